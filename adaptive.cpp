@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "adaptive.h"
+
+// adaptive.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // keeps near-black pixels from demanding endless samples for a relative error nobody can see
+    constexpr ir::Real LUMINANCE_FLOOR = .01f;
+
+    ir::Real luminance(const glm::vec3& color)
+    {
+        return glm::dot(color, glm::vec3{ .2126f, .7152f, .0722f });
+    }
+}
+
+namespace ir
+{
+    void PixelStatistics::add(const glm::vec3& radiance)
+    {
+        count++;
+        sequence++;
+
+        const auto inverse = 1.f / static_cast<Real>(count);
+        mean += (radiance - mean) * inverse;
+
+        const auto value = luminance(radiance);
+        const auto delta = value - luminance_mean;
+        luminance_mean += delta * inverse;
+        luminance_m2 += delta * (value - luminance_mean);
+    }
+
+    Real PixelStatistics::error(Real exposure) const
+    {
+        if (count < 2)
+        {
+            return std::numeric_limits<Real>::infinity();
+        }
+
+        const auto variance = luminance_m2 / static_cast<Real>(count - 1);
+        const auto standard_error = exposure * glm::sqrt(glm::max(variance, 0.f) / static_cast<Real>(count));
+        const auto value = exposure * luminance_mean;
+
+        // L / (1 + L) flattens bright values, shrinking their relative error by 1 + L
+        return standard_error / ((value + LUMINANCE_FLOOR) * (1.f + value));
+    }
+
+    void SampleAllocator::resize(std::size_t count)
+    {
+        statistics.assign(count, PixelStatistics{});
+        allocation.assign(count, samples);
+    }
+
+    void SampleAllocator::reset()
+    {
+        for (auto& pixel : statistics)
+        {
+            pixel = PixelStatistics{ .sequence = pixel.sequence };
+        }
+    }
+
+    void SampleAllocator::allocate(Real exposure)
+    {
+        if (!adaptive())
+        {
+            std::fill(allocation.begin(), allocation.end(), samples);
+            return;
+        }
+
+        auto budget = static_cast<double>(samples) * static_cast<double>(statistics.size());
+        auto total_error = 0.0;
+
+        settled = 0;
+
+        // settle the pixels still warming up or already converged first, so the rest can split whatever is left
+        auto errors = std::vector<Real>(statistics.size(), 0.f);
+        for (auto i = 0uz; i < statistics.size(); i++)
+        {
+            const auto& pixel = statistics[i];
+
+            if (pixel.count < MINIMUM_SAMPLES)
+            {
+                allocation[i] = samples;
+                budget -= samples;
+                continue;
+            }
+
+            auto error = pixel.error(exposure);
+
+            // identical samples show no variance rather than prove there is none, so they are taken at their word
+            // only once there are enough of them
+            if (pixel.luminance_m2 <= 0.f && pixel.count < MATCHING_SAMPLES)
+            {
+                error = threshold;
+            }
+
+            if (error < threshold)
+            {
+                settled++;
+
+                const auto retest = (frames + i) % RETEST_INTERVAL == 0;
+                allocation[i] = retest ? 1 : 0;
+                budget -= allocation[i];
+                continue;
+            }
+
+            errors[i] = error;
+            total_error += error;
+        }
+
+        frames++;
+
+        budget = std::max(budget, 0.0);
+
+        for (auto i = 0uz; i < statistics.size(); i++)
+        {
+            if (errors[i] <= 0.f)
+            {
+                continue;
+            }
+
+            const auto share = std::lround(budget * errors[i] / total_error);
+            allocation[i] = static_cast<std::uint32_t>(std::clamp<long>(share, 1, maximum()));
+        }
+    }
+
+    Real SampleAllocator::converged() const
+    {
+        if (allocation.empty())
+        {
+            return 0.f;
+        }
+
+        return static_cast<Real>(settled) / static_cast<Real>(allocation.size());
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef IRRADIANCE_ADAPTIVE_H
+#define IRRADIANCE_ADAPTIVE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// adaptive.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // running estimate of one pixel, updated one sample at a time with Welford's method
+    // https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Welford's_online_algorithm
+    struct PixelStatistics
+    {
+    public:
+        glm::vec3 mean = glm::vec3{ 0.f };
+        // spread is tracked on luminance alone, which is what the eye judges noise by
+        Real luminance_mean = 0.f;
+        Real luminance_m2 = 0.f;
+        std::uint32_t count = 0;
+        // samples ever taken by the pixel, never reset, so that every new sample continues its sequence
+        std::uint64_t sequence = 0;
+
+    public:
+        void add(const glm::vec3& radiance);
+
+        // relative standard error of the pixel after Reinhard tone mapping at the given exposure
+        Real error(Real exposure) const;
+    };
+
+    // splits a fixed per-frame budget of samples across the pixels. every pixel is sampled evenly until its variance
+    // can be trusted; from then on pixels whose error is under the threshold are sampled only now and then, to check
+    // they still are, and the rest share what the whole image would have taken in proportion to their error
+    class SampleAllocator
+    {
+    public:
+        // before this many samples a pixel's variance is too unreliable to stop on
+        static constexpr std::uint32_t MINIMUM_SAMPLES = 16;
+        // samples that must all agree before a pixel without any variance counts as converged. a light reached by
+        // one path in n is missed by all of them with a chance of about exp(-MATCHING_SAMPLES / n)
+        static constexpr std::uint32_t MATCHING_SAMPLES = 64;
+        // converged pixels still take a sample every this many frames, staggered across the image, so that one whose
+        // estimate was wrong sees its error climb again and rejoins the rest
+        static constexpr std::uint32_t RETEST_INTERVAL = 16;
+        // caps any one pixel at this many times the average budget per frame, so that no worker is left tracing
+        // a single pixel long after the others have finished
+        static constexpr std::uint32_t MAXIMUM_FACTOR = 8;
+
+    private:
+        // zero samples every pixel evenly, as without adaptive sampling
+        Real threshold;
+        std::uint32_t samples;
+        std::vector<PixelStatistics> statistics;
+        std::vector<std::uint32_t> allocation;
+        // allocations so far, to stagger the retests by
+        std::uint64_t frames = 0;
+        // pixels under the threshold at the last allocation
+        std::size_t settled = 0;
+
+    public:
+        SampleAllocator(Real threshold = 0.f, std::uint32_t samples = 1)
+            : threshold{ threshold }, samples{ samples }
+        {
+        }
+
+    public:
+        void resize(std::size_t count);
+        // forgets every estimate, as when the camera moves, but keeps each pixel's place in its sequence
+        void reset();
+        // decides how many samples each pixel takes this frame
+        void allocate(Real exposure);
+
+    public:
+        PixelStatistics& operator[](std::size_t pixel)
+        {
+            return statistics[pixel];
+        }
+
+        std::uint32_t samples_of(std::size_t pixel) const
+        {
+            return allocation[pixel];
+        }
+
+        std::uint32_t maximum() const
+        {
+            return samples * MAXIMUM_FACTOR;
+        }
+
+        bool adaptive() const
+        {
+            return threshold > 0.f;
+        }
+
+        // fraction of the pixels under the threshold, which are only sampled to retest them
+        Real converged() const;
+    };
+}
+
+#endif
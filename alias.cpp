@@ -0,0 +1,70 @@
+#include <numeric>
+
+#include "alias.h"
+
+// alias.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    void AliasTable::build(const std::vector<Real>& weights)
+    {
+        const auto count = weights.size();
+
+        bins.assign(count, Bin{ 1.f, 0 });
+        probabilities.assign(count, 0.f);
+
+        if (count == 0)
+        {
+            return;
+        }
+
+        // accumulated in double so that thousands of small weights do not lose precision against a large total
+        const auto total = std::accumulate(weights.begin(), weights.end(), 0.0, [](double sum, Real weight)
+        {
+            return sum + std::max(weight, 0.f);
+        });
+
+        for (auto i = 0uz; i < count; i++)
+        {
+            bins[i].alias = static_cast<std::uint32_t>(i);
+            probabilities[i] = total > 0.0 ? static_cast<Real>(std::max(weights[i], 0.f) / total) : 1.f / static_cast<Real>(count);
+        }
+
+        // weights scaled so that the average bin holds exactly one
+        auto scaled = std::vector<double>(count);
+        auto small = std::vector<std::uint32_t>{};
+        auto large = std::vector<std::uint32_t>{};
+
+        for (auto i = 0uz; i < count; i++)
+        {
+            scaled[i] = total > 0.0 ? std::max(weights[i], 0.f) / total * static_cast<double>(count) : 1.0;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+        }
+
+        // top up every underfull bin with the excess of an overfull one
+        while (!small.empty() && !large.empty())
+        {
+            const auto under = small.back();
+            small.pop_back();
+            const auto over = large.back();
+            large.pop_back();
+
+            bins[under] = Bin{ static_cast<Real>(scaled[under]), over };
+
+            scaled[over] = (scaled[over] + scaled[under]) - 1.0;
+            (scaled[over] < 1.0 ? small : large).push_back(over);
+        }
+
+        // whatever is left is full up to rounding error
+        for (const auto index : small)
+        {
+            bins[index] = Bin{ 1.f, index };
+        }
+
+        for (const auto index : large)
+        {
+            bins[index] = Bin{ 1.f, index };
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef IRRADIANCE_ALIAS_H
+#define IRRADIANCE_ALIAS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "utility.h"
+
+// alias.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // discrete distribution over weighted items that is sampled in constant time. each bin holds at most two items:
+    // its own index, kept with probability threshold, and an alias that takes the rest of the bin
+    // Vose's method https://www.keithschwarz.com/darts-dice-coins/
+    class AliasTable
+    {
+    private:
+        struct Bin
+        {
+            Real threshold;
+            std::uint32_t alias;
+        };
+
+    private:
+        std::vector<Bin> bins;
+        // normalized weight of each item, the probability that sample() returns it
+        std::vector<Real> probabilities;
+
+    public:
+        // linear in the number of weights; negative weights count as zero and an all-zero set is uniform
+        void build(const std::vector<Real>& weights);
+
+    public:
+        // a single uniform [0, 1) number picks the bin and then chooses between the bin and its alias.
+        // the choice only sees the bits of u left over after the bin, so probabilities are resolved to about 2^-24 * size()
+        std::uint32_t sample(Real u) const
+        {
+            const auto scaled = u * static_cast<Real>(bins.size());
+            const auto index = std::min(static_cast<std::uint32_t>(scaled), static_cast<std::uint32_t>(bins.size() - 1));
+            const auto remainder = scaled - static_cast<Real>(index);
+
+            return remainder < bins[index].threshold ? index : bins[index].alias;
+        }
+
+        Real probability(std::uint32_t index) const
+        {
+            return probabilities[index];
+        }
+
+        std::size_t size() const
+        {
+            return bins.size();
+        }
+
+        bool empty() const
+        {
+            return bins.empty();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef IRRADIANCE_ARENA_H
+#define IRRADIANCE_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// arena.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // bump allocator that owns everything made through it. objects are placed back to back in the order they
+    // are made, and are all destroyed and freed together by clear() or when the arena itself goes away
+    class Arena
+    {
+    public:
+        static constexpr std::size_t BLOCK_SIZE = std::size_t{ 64 } << 10;
+
+    private:
+        struct Destructor
+        {
+            void (*destroy)(void*);
+            void* object;
+        };
+
+    private:
+        std::vector<std::unique_ptr<std::byte[]>> blocks;
+        // bump offset and size of the last block
+        std::size_t offset = 0;
+        std::size_t capacity = 0;
+        // only types with non-trivial destructors are recorded here
+        std::vector<Destructor> destructors;
+
+    public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena()
+        {
+            clear();
+        }
+
+    public:
+        template<typename T, typename... Args>
+        T* make(Args&&... args)
+        {
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "blocks are only aligned for the default new alignment");
+
+            auto object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                destructors.push_back(Destructor{ [](void* object) { static_cast<T*>(object)->~T(); }, object });
+            }
+
+            return object;
+        }
+
+        // destroys in reverse order of creation, so that anything referring to earlier objects goes first
+        void clear()
+        {
+            for (auto destructor = destructors.rbegin(); destructor != destructors.rend(); destructor++)
+            {
+                destructor->destroy(destructor->object);
+            }
+
+            destructors.clear();
+            blocks.clear();
+            offset = 0;
+            capacity = 0;
+        }
+
+    private:
+        void* allocate(std::size_t size, std::size_t alignment)
+        {
+            offset = (offset + alignment - 1) & ~(alignment - 1);
+
+            if (blocks.empty() || offset + size > capacity)
+            {
+                // objects larger than a block get a block of their own
+                capacity = std::max(BLOCK_SIZE, size);
+                blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(capacity));
+                offset = 0;
+            }
+
+            const auto memory = blocks.back().get() + offset;
+            offset += size;
+            return memory;
+        }
+    };
+}
+
+#endif
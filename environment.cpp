@@ -0,0 +1,171 @@
+#include <algorithm>
+
+#include "glm/gtc/constants.hpp"
+
+#include "environment.h"
+
+// environment.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // index of the interval of cdf that u falls in, and how far across it, so that u maps continuously onto the cells
+    std::pair<std::uint32_t, ir::Real> invert(const ir::Real* cdf, std::uint32_t count, ir::Real u)
+    {
+        // last entry not greater than u, skipping the leading zero-width intervals of black cells
+        const auto upper = std::upper_bound(cdf, cdf + count + 1, u);
+        const auto index = static_cast<std::uint32_t>(std::clamp<std::ptrdiff_t>(upper - cdf - 1, 0, count - 1));
+
+        const auto width = cdf[index + 1] - cdf[index];
+        const auto offset = width > 0.f ? (u - cdf[index]) / width : .5f;
+
+        return { index, glm::clamp(offset, 0.f, 1.f) };
+    }
+}
+
+namespace ir
+{
+    glm::vec2 environment_uv(const glm::vec3& direction)
+    {
+        const auto theta = glm::atan(direction.z, direction.x);
+        const auto phi = glm::acos(glm::clamp(-direction.y, -1.f, 1.f));
+
+        auto u = (theta + glm::pi<Real>()) / (2.f * glm::pi<Real>());
+        auto v = phi / glm::pi<Real>();
+
+        u = 1.f - u;
+
+        return { u, v };
+    }
+
+    glm::vec3 environment_direction(const glm::vec2& uv)
+    {
+        const auto theta = (1.f - uv.x) * 2.f * glm::pi<Real>() - glm::pi<Real>();
+        const auto phi = uv.y * glm::pi<Real>();
+
+        const auto sin_phi = glm::sin(phi);
+
+        return glm::vec3{ sin_phi * glm::cos(theta), -glm::cos(phi), sin_phi * glm::sin(theta) };
+    }
+
+    void EnvironmentMap::build(const olc::Sprite& image)
+    {
+        width = std::min(static_cast<std::uint32_t>(image.width), MAXIMUM_WIDTH);
+        height = std::min(static_cast<std::uint32_t>(image.height), MAXIMUM_HEIGHT);
+
+        function.assign(static_cast<std::size_t>(width) * height, 0.f);
+        conditional.assign(static_cast<std::size_t>(width + 1) * height, 0.f);
+        marginal.assign(height + 1, 0.f);
+        average = 0.f;
+
+        if (width == 0 || height == 0)
+        {
+            return;
+        }
+
+        for (auto y = 0u; y < height; y++)
+        {
+            // every texel that overlaps the cell, even partly, so that no lit texel is left with zero density
+            const auto y0 = static_cast<std::int32_t>(static_cast<std::uint64_t>(y) * image.height / height);
+            const auto y1 = std::max(y0 + 1, static_cast<std::int32_t>((static_cast<std::uint64_t>(y + 1) * image.height + height - 1) / height));
+
+            // rows near the poles cover less of the sphere
+            const auto sin_phi = glm::sin(glm::pi<Real>() * (static_cast<Real>(y) + .5f) / static_cast<Real>(height));
+
+            for (auto x = 0u; x < width; x++)
+            {
+                const auto x0 = static_cast<std::int32_t>(static_cast<std::uint64_t>(x) * image.width / width);
+                const auto x1 = std::max(x0 + 1, static_cast<std::int32_t>((static_cast<std::uint64_t>(x + 1) * image.width + width - 1) / width));
+
+                auto sum = 0.0;
+                for (auto j = y0; j < y1; j++)
+                {
+                    for (auto i = x0; i < x1; i++)
+                    {
+                        const auto pixel = image.GetPixel(i, j);
+                        sum += .2126 * pixel.r + .7152 * pixel.g + .0722 * pixel.b;
+                    }
+                }
+
+                function[y * width + x] = static_cast<Real>(sum / ((y1 - y0) * (x1 - x0)) / 255.0) * sin_phi;
+            }
+        }
+
+        // accumulated in double for the same reason as AliasTable::build
+        auto total = 0.0;
+        for (auto y = 0u; y < height; y++)
+        {
+            auto* const cdf = &conditional[static_cast<std::size_t>(y) * (width + 1)];
+
+            auto row = 0.0;
+            for (auto x = 0u; x < width; x++)
+            {
+                row += function[y * width + x];
+                cdf[x + 1] = static_cast<Real>(row);
+            }
+
+            // a black row is never chosen, but keep its distribution valid anyway
+            for (auto x = 1u; x <= width; x++)
+            {
+                cdf[x] = row > 0.0 ? static_cast<Real>(cdf[x] / row) : static_cast<Real>(x) / static_cast<Real>(width);
+            }
+
+            total += row;
+            marginal[y + 1] = static_cast<Real>(total);
+        }
+
+        if (total <= 0.0)
+        {
+            return;
+        }
+
+        for (auto y = 1u; y <= height; y++)
+        {
+            marginal[y] = static_cast<Real>(marginal[y] / total);
+        }
+
+        average = static_cast<Real>(total / (static_cast<double>(width) * height));
+    }
+
+    EnvironmentSample EnvironmentMap::sample(const glm::vec2& u) const
+    {
+        if (empty())
+        {
+            return EnvironmentSample{ glm::vec3{ 0.f, 1.f, 0.f }, 0.f };
+        }
+
+        const auto [y, dy] = invert(marginal.data(), height, u.y);
+        const auto [x, dx] = invert(&conditional[static_cast<std::size_t>(y) * (width + 1)], width, u.x);
+
+        const auto uv = glm::vec2
+        {
+            (static_cast<Real>(x) + dx) / static_cast<Real>(width),
+            (static_cast<Real>(y) + dy) / static_cast<Real>(height),
+        };
+
+        const auto direction = environment_direction(uv);
+
+        return EnvironmentSample{ direction, pdf(direction) };
+    }
+
+    Real EnvironmentMap::pdf(const glm::vec3& direction) const
+    {
+        if (empty())
+        {
+            return 0.f;
+        }
+
+        const auto uv = environment_uv(direction);
+        const auto x = std::min(static_cast<std::uint32_t>(uv.x * static_cast<Real>(width)), width - 1);
+        const auto y = std::min(static_cast<std::uint32_t>(uv.y * static_cast<Real>(height)), height - 1);
+
+        const auto sin_phi = glm::sin(uv.y * glm::pi<Real>());
+        if (sin_phi <= 0.f)
+        {
+            return 0.f;
+        }
+
+        // density over the unit square, divided by the area element 2 pi^2 sin(phi) of the equirectangular mapping
+        return function[y * width + x] / average / (2.f * glm::pi<Real>() * glm::pi<Real>() * sin_phi);
+    }
+}
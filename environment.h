@@ -0,0 +1,67 @@
+#ifndef IRRADIANCE_ENVIRONMENT_H
+#define IRRADIANCE_ENVIRONMENT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+#include "olcPixelGameEngine.h"
+
+// environment.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // equirectangular mapping between directions and skybox texture coordinates, v = 0 straight up
+    glm::vec2 environment_uv(const glm::vec3& direction);
+    glm::vec3 environment_direction(const glm::vec2& uv);
+
+    struct EnvironmentSample
+    {
+        glm::vec3 direction;
+        // per unit solid angle; zero when the environment is black everywhere
+        Real pdf = 0.f;
+    };
+
+    // the skybox treated as a light at infinity, sampled in proportion to its brightness. a piecewise-constant
+    // distribution over a grid of cells is inverted through the marginal distribution of rows and then the
+    // conditional distribution of columns within the chosen row
+    // https://pbr-book.org/4ed/Monte_Carlo_Integration/Sampling_Using_the_Inversion_Method#PiecewiseConstant2D
+    class EnvironmentMap
+    {
+    private:
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        // unnormalized brightness of each cell, row by row
+        std::vector<Real> function;
+        // cumulative distribution over the columns of each row, width + 1 entries per row
+        std::vector<Real> conditional;
+        // cumulative distribution over the rows, height + 1 entries
+        std::vector<Real> marginal;
+        // average of function over the whole grid, which normalizes it into a density over [0, 1)^2
+        Real average = 0.f;
+
+    public:
+        // cells are capped at this resolution; each covers the average of the texels beneath it, so the density is
+        // nonzero wherever the texture is
+        static constexpr std::uint32_t MAXIMUM_WIDTH = 1024;
+        static constexpr std::uint32_t MAXIMUM_HEIGHT = 512;
+
+    public:
+        void build(const olc::Sprite& image);
+
+    public:
+        // u picks the row with y and the column within it with x, so stratified samples stay stratified over the sky
+        EnvironmentSample sample(const glm::vec2& u) const;
+        Real pdf(const glm::vec3& direction) const;
+
+        bool empty() const
+        {
+            return average <= 0.f;
+        }
+    };
+}
+
+#endif
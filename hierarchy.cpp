@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <numeric>
+
+#include "hierarchy.h"
+
+// hierarchy.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    struct Bin
+    {
+        glm::vec3 minimum = glm::vec3{ std::numeric_limits<ir::Real>::max() };
+        glm::vec3 maximum = glm::vec3{ -std::numeric_limits<ir::Real>::max() };
+        std::uint32_t count = 0;
+    };
+
+    ir::Real half_area(const glm::vec3& minimum, const glm::vec3& maximum)
+    {
+        // only relative surface areas matter for the heuristic, so the factor of two is dropped
+        const auto extent = glm::max(maximum - minimum, glm::vec3{ 0.f });
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+}
+
+namespace ir
+{
+    bool BoundingVolume::contains(const glm::vec3& point) const
+    {
+        return (point.x >= origin.x) && (point.x <= origin.x + size.x) &&
+               (point.y >= origin.y) && (point.y <= origin.y + size.y) &&
+               (point.z >= origin.z) && (point.z <= origin.z + size.z);
+    }
+
+    bool BoundingVolume::intersects(const BoundingVolume& other) const
+    {
+        return (origin.x <= other.origin.x + other.size.x) && (origin.x + size.x >= other.origin.x) &&
+               (origin.y <= other.origin.y + other.size.y) && (origin.y + size.y >= other.origin.y) &&
+               (origin.z <= other.origin.z + other.size.z) && (origin.z + size.z >= other.origin.z);
+    }
+
+    void BoundingVolumeHierarchy::build(const std::vector<BoundingVolume>& volumes, const std::vector<glm::vec3>& centroids, std::uint32_t lane_width)
+    {
+        // number of (possibly SIMD) intersection tests needed for a given primitive count
+        const auto tests = [&](std::uint32_t count)
+        {
+            return static_cast<Real>((count + lane_width - 1) / lane_width);
+        };
+
+        nodes.clear();
+        indices.resize(volumes.size());
+        std::iota(indices.begin(), indices.end(), 0u);
+
+        if (volumes.empty())
+        {
+            return;
+        }
+
+        // a binary tree with one or more primitives per leaf never exceeds 2N - 1 nodes,
+        // so reserving up front keeps node references stable during the build
+        nodes.reserve(2 * volumes.size() - 1);
+        nodes.push_back(BoundingVolumeNode{ glm::vec3{ 0.f }, 0, glm::vec3{ 0.f }, static_cast<std::uint32_t>(volumes.size()) });
+
+        struct Task
+        {
+            std::uint32_t node;
+            std::size_t depth;
+        };
+
+        auto tasks = std::vector<Task>{ Task{ 0, 0 } };
+
+        while (!tasks.empty())
+        {
+            const auto task = tasks.back();
+            tasks.pop_back();
+
+            auto& node = nodes[task.node];
+
+            // fit the node to its primitives and their centroids
+            node.minimum = glm::vec3{ std::numeric_limits<Real>::max() };
+            node.maximum = glm::vec3{ -std::numeric_limits<Real>::max() };
+            auto centroid_minimum = glm::vec3{ std::numeric_limits<Real>::max() };
+            auto centroid_maximum = glm::vec3{ -std::numeric_limits<Real>::max() };
+
+            for (auto i = node.first; i < node.first + node.count; i++)
+            {
+                const auto& volume = volumes[indices[i]];
+                node.minimum = glm::min(node.minimum, volume.origin);
+                node.maximum = glm::max(node.maximum, volume.origin + volume.size);
+                centroid_minimum = glm::min(centroid_minimum, centroids[indices[i]]);
+                centroid_maximum = glm::max(centroid_maximum, centroids[indices[i]]);
+            }
+
+            if (node.count <= 1 || task.depth + 1 >= MAX_DEPTH)
+            {
+                continue;
+            }
+
+            // evaluate the surface area heuristic at each bin boundary along every axis
+            const auto leaf_cost = tests(node.count) * half_area(node.minimum, node.maximum);
+            auto best_cost = std::numeric_limits<Real>::infinity();
+            auto best_axis = -1;
+            auto best_split = 0uz;
+
+            const auto centroid_extent = centroid_maximum - centroid_minimum;
+
+            for (auto axis = 0; axis < 3; axis++)
+            {
+                if (centroid_extent[axis] <= 0.f)
+                {
+                    // all centroids coincide along this axis
+                    continue;
+                }
+
+                const auto scale = static_cast<Real>(BIN_COUNT) / centroid_extent[axis];
+
+                auto bins = std::array<Bin, BIN_COUNT>{};
+                for (auto i = node.first; i < node.first + node.count; i++)
+                {
+                    const auto& volume = volumes[indices[i]];
+                    const auto bin = glm::min(static_cast<std::size_t>((centroids[indices[i]][axis] - centroid_minimum[axis]) * scale), BIN_COUNT - 1);
+
+                    bins[bin].minimum = glm::min(bins[bin].minimum, volume.origin);
+                    bins[bin].maximum = glm::max(bins[bin].maximum, volume.origin + volume.size);
+                    bins[bin].count++;
+                }
+
+                // sweep from both ends to accumulate the cost of every candidate plane
+                auto left_costs = std::array<Real, BIN_COUNT - 1>{};
+                auto right_costs = std::array<Real, BIN_COUNT - 1>{};
+
+                auto left = Bin{}, right = Bin{};
+                for (auto i = 0uz; i < BIN_COUNT - 1; i++)
+                {
+                    left.minimum = glm::min(left.minimum, bins[i].minimum);
+                    left.maximum = glm::max(left.maximum, bins[i].maximum);
+                    left.count += bins[i].count;
+                    left_costs[i] = tests(left.count) * half_area(left.minimum, left.maximum);
+
+                    const auto j = BIN_COUNT - 1 - i;
+                    right.minimum = glm::min(right.minimum, bins[j].minimum);
+                    right.maximum = glm::max(right.maximum, bins[j].maximum);
+                    right.count += bins[j].count;
+                    right_costs[j - 1] = tests(right.count) * half_area(right.minimum, right.maximum);
+                }
+
+                for (auto i = 0uz; i < BIN_COUNT - 1; i++)
+                {
+                    const auto cost = left_costs[i] + right_costs[i];
+                    if (cost < best_cost)
+                    {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_split = i + 1;
+                    }
+                }
+            }
+
+            best_cost += TRAVERSAL_COST * half_area(node.minimum, node.maximum);
+
+            if (best_cost >= leaf_cost && node.count <= MAX_LEAF_SIZE)
+            {
+                // splitting would be no cheaper than testing every primitive here
+                continue;
+            }
+
+            const auto begin = indices.begin() + node.first;
+            const auto end = begin + node.count;
+            auto middle = begin;
+
+            if (best_axis >= 0)
+            {
+                const auto scale = static_cast<Real>(BIN_COUNT) / centroid_extent[best_axis];
+                middle = std::partition(begin, end, [&](std::uint32_t index)
+                {
+                    const auto bin = glm::min(static_cast<std::size_t>((centroids[index][best_axis] - centroid_minimum[best_axis]) * scale), BIN_COUNT - 1);
+                    return bin < best_split;
+                });
+            }
+
+            if (middle == begin || middle == end)
+            {
+                // coincident centroids cannot be separated spatially, so halve the range instead
+                middle = begin + node.count / 2;
+            }
+
+            const auto left_count = static_cast<std::uint32_t>(middle - begin);
+            const auto left_index = static_cast<std::uint32_t>(nodes.size());
+
+            nodes.push_back(BoundingVolumeNode{ glm::vec3{ 0.f }, node.first, glm::vec3{ 0.f }, left_count });
+            nodes.push_back(BoundingVolumeNode{ glm::vec3{ 0.f }, node.first + left_count, glm::vec3{ 0.f }, node.count - left_count });
+
+            node.first = left_index;
+            node.count = 0;
+
+            tasks.push_back(Task{ left_index, task.depth + 1 });
+            tasks.push_back(Task{ left_index + 1, task.depth + 1 });
+        }
+    }
+
+    bool BoundingVolumeHierarchy::empty() const
+    {
+        return nodes.empty();
+    }
+}
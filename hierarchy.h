@@ -0,0 +1,181 @@
+#ifndef IRRADIANCE_HIERARCHY_H
+#define IRRADIANCE_HIERARCHY_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/glm.hpp"
+#include "glm/gtx/component_wise.hpp"
+
+#include "utility.h"
+
+// hierarchy.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    struct BoundingVolume
+    {
+    public:
+        glm::vec3 origin;
+        glm::vec3 size;
+
+    public:
+        BoundingVolume(const glm::vec3& origin, const glm::vec3& size)
+            : origin{ origin }, size{ size }
+        {
+        }
+
+    public:
+        bool contains(const glm::vec3& point) const;
+        bool intersects(const BoundingVolume& other) const;
+    };
+
+    struct BoundingVolumeNode
+    {
+        glm::vec3 minimum;
+        // interior nodes: index of the left child (the right child immediately follows)
+        // leaf nodes: offset of the first primitive within the index list
+        std::uint32_t first;
+        glm::vec3 maximum;
+        // 0 for interior nodes, otherwise the number of primitives in the leaf
+        std::uint32_t count;
+    };
+
+    // slab test against an axis-aligned box, returning the entry distance or infinity on a miss
+    inline Real intersect_box(const glm::vec3& minimum, const glm::vec3& maximum, const glm::vec3& origin, const glm::vec3& reciprocal, Real t_max)
+    {
+        const auto t0 = (minimum - origin) * reciprocal;
+        const auto t1 = (maximum - origin) * reciprocal;
+
+        const auto tmin = glm::max(glm::compMax(glm::min(t0, t1)), 0.f);
+        const auto tmax = glm::compMin(glm::max(t0, t1));
+
+        if (tmin <= tmax && tmin < t_max)
+        {
+            return tmin;
+        }
+
+        return std::numeric_limits<Real>::infinity();
+    }
+
+    // bounding volume hierarchy over an arbitrary set of primitives, built by binned surface area heuristic
+    // https://jacco.ompf2.com/2022/04/21/how-to-build-a-bvh-part-3-quick-builds/
+    class BoundingVolumeHierarchy
+    {
+    public:
+        static constexpr std::size_t BIN_COUNT = 12;
+        static constexpr std::uint32_t MAX_LEAF_SIZE = 4;
+        static constexpr std::size_t MAX_DEPTH = 64;
+        // cost of stepping into a node relative to a single primitive intersection
+        static constexpr Real TRAVERSAL_COST = 1.f;
+
+    public:
+        std::vector<BoundingVolumeNode> nodes;
+        // primitive indices reordered such that every leaf references a contiguous range
+        std::vector<std::uint32_t> indices;
+
+    public:
+        // lane_width > 1 tells the heuristic that leaves are intersected that many primitives at a time
+        void build(const std::vector<BoundingVolume>& volumes, const std::vector<glm::vec3>& centroids, std::uint32_t lane_width = 1);
+        bool empty() const;
+
+    public:
+        // visits candidate primitives front-to-back, skipping any node beyond t_max.
+        // t_max is re-read after every visit so that the caller may tighten it as nearer hits are found;
+        // returning true from visit terminates the traversal early
+        template<typename F>
+        void traverse(const Ray& ray, const Real& t_max, F&& visit) const
+        {
+            traverse_leaves(ray, t_max, [&](std::uint32_t leaf)
+            {
+                const auto& node = nodes[leaf];
+                for (auto i = node.first; i < node.first + node.count; i++)
+                {
+                    if (visit(indices[i]))
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            });
+        }
+
+        // same front-to-back walk as traverse(), but hands each whole leaf (by node index) to visit
+        // so that callers can intersect its primitives in bulk
+        template<typename F>
+        void traverse_leaves(const Ray& ray, const Real& t_max, F&& visit) const
+        {
+            if (nodes.empty())
+            {
+                return;
+            }
+
+            const auto reciprocal = 1.f / ray.direction;
+
+            struct Entry
+            {
+                std::uint32_t node;
+                Real distance;
+            };
+
+            auto stack = std::array<Entry, MAX_DEPTH>{};
+            auto top = 0uz;
+
+            const auto& root = nodes[0];
+            const auto root_distance = intersect_box(root.minimum, root.maximum, ray.origin, reciprocal, t_max);
+            if (root_distance == std::numeric_limits<Real>::infinity())
+            {
+                return;
+            }
+
+            stack[top++] = Entry{ 0, root_distance };
+
+            while (top > 0)
+            {
+                const auto entry = stack[--top];
+                if (entry.distance >= t_max)
+                {
+                    // a nearer hit was found since this node was queued
+                    continue;
+                }
+
+                const auto& node = nodes[entry.node];
+
+                if (node.count > 0)
+                {
+                    if (visit(entry.node))
+                    {
+                        return;
+                    }
+
+                    continue;
+                }
+
+                auto nearer = Entry{ node.first, intersect_box(nodes[node.first].minimum, nodes[node.first].maximum, ray.origin, reciprocal, t_max) };
+                auto farther = Entry{ node.first + 1, intersect_box(nodes[node.first + 1].minimum, nodes[node.first + 1].maximum, ray.origin, reciprocal, t_max) };
+
+                if (farther.distance < nearer.distance)
+                {
+                    std::swap(nearer, farther);
+                }
+
+                // push the farther child first so that the nearer child is popped (and therefore visited) first
+                if (farther.distance != std::numeric_limits<Real>::infinity())
+                {
+                    stack[top++] = farther;
+                }
+
+                if (nearer.distance != std::numeric_limits<Real>::infinity())
+                {
+                    stack[top++] = nearer;
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+#include "glm/gtc/constants.hpp"
+
+#include "irradiance.h"
+
+// irradiance.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // reach of a record in Ward's error measure, beyond which it is never interpolated
+    ir::Real reach(const ir::IrradianceRecord& record, ir::Real accuracy)
+    {
+        return accuracy * record.radius;
+    }
+
+    // level of the grid whose cells are at least as wide as the reach, so a record spans no more than two per axis
+    int level_of(ir::Real reach)
+    {
+        return static_cast<int>(glm::ceil(glm::log2(glm::max(reach, std::numeric_limits<ir::Real>::min()))));
+    }
+
+    glm::ivec3 cell_of(const glm::vec3& position, int level)
+    {
+        return glm::ivec3{ glm::floor(position / std::ldexp(1.f, level)) };
+    }
+
+    ir::Real luminance(const glm::vec3& color)
+    {
+        return glm::dot(color, glm::vec3{ .2126f, .7152f, .0722f });
+    }
+}
+
+namespace ir
+{
+    glm::vec3 IrradianceGather::direction(std::uint32_t j, std::uint32_t k, const glm::vec2& u)
+    {
+        // equal strata of sin^2(theta) are equal shares of the cosine-weighted hemisphere
+        const auto sin2_theta = (static_cast<Real>(j) + u.x) / static_cast<Real>(THETA);
+        const auto phi = 2.f * glm::pi<Real>() * (static_cast<Real>(k) + u.y) / static_cast<Real>(PHI);
+
+        const auto sin_theta = glm::sqrt(sin2_theta);
+        const auto cos_theta = glm::sqrt(glm::max(0.f, 1.f - sin2_theta));
+
+        return glm::vec3{ sin_theta * glm::cos(phi), sin_theta * glm::sin(phi), cos_theta };
+    }
+
+    std::size_t IrradianceCache::CellHash::operator()(const Cell& cell) const
+    {
+        // https://matthias-research.github.io/pages/publications/tetraederCollision.pdf
+        const auto x = static_cast<std::size_t>(cell.index.x) * 73856093uz;
+        const auto y = static_cast<std::size_t>(cell.index.y) * 19349663uz;
+        const auto z = static_cast<std::size_t>(cell.index.z) * 83492791uz;
+        const auto level = static_cast<std::size_t>(cell.level) * 2654435761uz;
+
+        return x ^ y ^ z ^ level;
+    }
+
+    void IrradianceCache::reset(const glm::vec3& camera, Real pixel_angle)
+    {
+        const auto lock = std::unique_lock{ mutex };
+
+        this->camera = camera;
+        this->pixel_angle = pixel_angle;
+
+        records.clear();
+        cells.clear();
+        minimum_level = std::numeric_limits<int>::max();
+        maximum_level = std::numeric_limits<int>::min();
+    }
+
+    bool IrradianceCache::lookup(const glm::vec3& position, const glm::vec3& normal, glm::vec3& irradiance) const
+    {
+        const auto lock = std::shared_lock{ mutex };
+
+        auto sum = glm::vec3{ 0.f };
+        auto total = 0.f;
+
+        for (auto level = minimum_level; level <= maximum_level; level++)
+        {
+            const auto found = cells.find(Cell{ level, cell_of(position, level) });
+            if (found == cells.end())
+            {
+                continue;
+            }
+
+            for (const auto index : found->second)
+            {
+                const auto& record = records[index];
+                const auto offset = position - record.position;
+
+                // a record lying in front of the point may see light that the point cannot
+                if (glm::dot(offset, .5f * (normal + record.normal)) < -.05f * record.radius)
+                {
+                    continue;
+                }
+
+                const auto error = glm::length(offset) / record.radius + glm::sqrt(glm::max(0.f, 1.f - glm::dot(normal, record.normal)));
+                if (error >= accuracy)
+                {
+                    continue;
+                }
+
+                // Ward's weight less its value at the edge of the reach, so that records fade out rather than pop
+                const auto weight = 1.f / glm::max(error, 1e-4f) - 1.f / accuracy;
+
+                const auto extrapolated = record.irradiance
+                    + glm::transpose(record.rotation) * glm::cross(record.normal, normal)
+                    + glm::transpose(record.translation) * offset;
+
+                sum += weight * glm::max(extrapolated, glm::vec3{ 0.f });
+                total += weight;
+            }
+        }
+
+        if (total <= 0.f)
+        {
+            return false;
+        }
+
+        irradiance = sum / total;
+        return true;
+    }
+
+    IrradianceRecord IrradianceCache::record(const glm::vec3& position, const glm::mat3& basis, const IrradianceGather& gather) const
+    {
+        constexpr auto M = IrradianceGather::THETA;
+        constexpr auto N = IrradianceGather::PHI;
+
+        const auto at = [](std::uint32_t j, std::uint32_t k) { return j * N + (k % N); };
+
+        const auto footprint = glm::distance(position, camera) * pixel_angle / accuracy;
+        const auto minimum_radius = MINIMUM_SPACING * footprint;
+        const auto maximum_radius = MAXIMUM_SPACING * footprint;
+
+        // of two neighbouring strata, kept from approaching zero so that a crease at the point cannot blow up the gradient
+        const auto nearer = [&](std::uint32_t a, std::uint32_t b) { return glm::max(glm::min(gather.distances[a], gather.distances[b]), minimum_radius); };
+
+        auto irradiance = glm::vec3{ 0.f };
+        auto inverse_distance = 0.f;
+        auto rotation = glm::mat3{ 0.f };
+
+        for (auto i = 0u; i < IrradianceGather::COUNT; i++)
+        {
+            const auto& direction = gather.directions[i];
+            const auto& radiance = gather.radiance[i];
+
+            irradiance += radiance;
+            inverse_distance += 1.f / gather.distances[i];
+
+            // turning the normal about the perpendicular axis tilts it toward a direction, raising its cosine by the
+            // direction's share of the base plane; over the cosine-weighted density that is tan(theta)
+            const auto sin_theta = glm::length(glm::vec2{ direction });
+            if (sin_theta > 0.f && direction.z > 0.f)
+            {
+                const auto perpendicular = glm::vec3{ -direction.y, direction.x, 0.f } / sin_theta;
+                rotation += glm::outerProduct(perpendicular, radiance * (sin_theta / direction.z));
+            }
+        }
+
+        // Ward and Heckbert's translational gradient: how the boundaries between neighbouring strata move across
+        // the surroundings as the point does, nearer surroundings moving faster
+        // https://radsite.lbl.gov/radiance/papers/erw92/paper.html
+        auto translation = glm::mat3{ 0.f };
+        for (auto k = 0u; k < N; k++)
+        {
+            const auto phi = 2.f * glm::pi<Real>() * (static_cast<Real>(k) + .5f) / static_cast<Real>(N);
+            const auto phi_boundary = 2.f * glm::pi<Real>() * static_cast<Real>(k) / static_cast<Real>(N);
+
+            const auto u = glm::vec3{ glm::cos(phi), glm::sin(phi), 0.f };
+            const auto v = glm::vec3{ -glm::sin(phi_boundary), glm::cos(phi_boundary), 0.f };
+
+            // across the boundaries in elevation, between strata j - 1 and j
+            auto elevation = glm::vec3{ 0.f };
+            for (auto j = 1u; j < M; j++)
+            {
+                const auto sin2_theta = static_cast<Real>(j) / static_cast<Real>(M);
+                const auto distance = nearer(at(j, k), at(j - 1, k));
+
+                elevation += glm::sqrt(sin2_theta) * (1.f - sin2_theta) / distance * (gather.radiance[at(j, k)] - gather.radiance[at(j - 1, k)]);
+            }
+
+            // across the boundary in azimuth, between strata k - 1 and k
+            auto azimuth = glm::vec3{ 0.f };
+            for (auto j = 0u; j < M; j++)
+            {
+                const auto cos_lower = glm::sqrt(1.f - static_cast<Real>(j) / static_cast<Real>(M));
+                const auto cos_upper = glm::sqrt(1.f - static_cast<Real>(j + 1) / static_cast<Real>(M));
+                const auto sin_theta = glm::sqrt((static_cast<Real>(j) + .5f) / static_cast<Real>(M));
+                const auto distance = nearer(at(j, k), at(j, k + N - 1));
+
+                azimuth += (cos_lower - cos_upper) / (sin_theta * distance) * (gather.radiance[at(j, k)] - gather.radiance[at(j, k + N - 1)]);
+            }
+
+            translation += glm::outerProduct(u, elevation * (2.f * glm::pi<Real>() / static_cast<Real>(N)));
+            translation += glm::outerProduct(v, azimuth);
+        }
+
+        const auto scale = glm::pi<Real>() / static_cast<Real>(IrradianceGather::COUNT);
+        irradiance *= scale;
+        rotation *= scale;
+
+        // harmonic mean distance to the surroundings, infinite if they are all sky
+        auto radius = static_cast<Real>(IrradianceGather::COUNT) / inverse_distance;
+
+        // nor may the gradient carry the irradiance past zero within the record's reach
+        const auto gradient = glm::length(translation * glm::vec3{ .2126f, .7152f, .0722f });
+        if (gradient > 0.f)
+        {
+            radius = glm::min(radius, luminance(irradiance) / gradient);
+        }
+
+        radius = glm::clamp(radius, minimum_radius, maximum_radius);
+
+        return IrradianceRecord
+        {
+            .position = position,
+            .normal = basis[2],
+            .irradiance = irradiance,
+            .rotation = basis * rotation,
+            .translation = basis * translation,
+            .radius = radius,
+        };
+    }
+
+    void IrradianceCache::insert(const IrradianceRecord& record)
+    {
+        if (!(record.radius > 0.f))
+        {
+            return;
+        }
+
+        const auto extent = reach(record, accuracy);
+        const auto level = level_of(extent);
+
+        const auto lock = std::unique_lock{ mutex };
+
+        const auto index = static_cast<std::uint32_t>(records.size());
+        records.push_back(record);
+
+        // every cell of the level that the reach overlaps, at most two per axis
+        const auto minimum = cell_of(record.position - extent, level);
+        const auto maximum = cell_of(record.position + extent, level);
+        for (auto z = minimum.z; z <= maximum.z; z++)
+        {
+            for (auto y = minimum.y; y <= maximum.y; y++)
+            {
+                for (auto x = minimum.x; x <= maximum.x; x++)
+                {
+                    cells[Cell{ level, glm::ivec3{ x, y, z } }].push_back(index);
+                }
+            }
+        }
+
+        minimum_level = std::min(minimum_level, level);
+        maximum_level = std::max(maximum_level, level);
+    }
+
+    std::size_t IrradianceCache::size() const
+    {
+        const auto lock = std::shared_lock{ mutex };
+        return records.size();
+    }
+}
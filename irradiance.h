@@ -0,0 +1,131 @@
+#ifndef IRRADIANCE_IRRADIANCE_H
+#define IRRADIANCE_IRRADIANCE_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// irradiance.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // irradiance arriving at one surface point from everything but next-event estimation, and how it changes nearby.
+    // each gradient holds one column per color channel, so transpose(gradient) * offset is the change in irradiance
+    struct IrradianceRecord
+    {
+    public:
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec3 irradiance;
+        // per radian of the normal rotating about an axis
+        glm::mat3 rotation;
+        // per unit of distance moved across the surface
+        glm::mat3 translation;
+        // distance to the surroundings, beyond which the record is no longer trusted
+        Real radius;
+    };
+
+    // radiance and hit distance along a stratified, cosine-weighted set of directions about the +z normal, from
+    // which a record and its gradients are estimated
+    // https://cgg.mff.cuni.cz/~jaroslav/papers/2008-irradiance_caching_class/
+    struct IrradianceGather
+    {
+    public:
+        // strata in the elevation and the azimuth, the latter roughly pi times the former so that strata are square-ish
+        static constexpr std::uint32_t THETA = 8;
+        static constexpr std::uint32_t PHI = 24;
+        static constexpr std::uint32_t COUNT = THETA * PHI;
+
+    public:
+        std::array<glm::vec3, COUNT> directions;
+        std::array<glm::vec3, COUNT> radiance;
+        // infinite for rays that escaped the scene
+        std::array<Real, COUNT> distances;
+
+    public:
+        // direction within stratum (j, k), in the frame whose z axis is the normal
+        static glm::vec3 direction(std::uint32_t j, std::uint32_t k, const glm::vec2& u);
+
+        void add(std::uint32_t j, std::uint32_t k, const glm::vec3& direction, const glm::vec3& radiance, Real distance)
+        {
+            directions[j * PHI + k] = direction;
+            this->radiance[j * PHI + k] = radiance;
+            distances[j * PHI + k] = distance;
+        }
+    };
+
+    // world-space cache of irradiance records over diffuse surfaces, interpolated with their gradients.
+    // records are found through a hash grid with one level per power of two of their reach, so every query checks
+    // just one cell per level. shared between render workers: lookups share a lock and insertions take it outright
+    // https://radsite.lbl.gov/radiance/papers/sg88/paper.html
+    class IrradianceCache
+    {
+    public:
+        // reach of a record on screen, in pixels at its distance from the camera, so that detail is neither
+        // oversampled up close nor smeared across the image far away
+        static constexpr Real MINIMUM_SPACING = 1.5f;
+        static constexpr Real MAXIMUM_SPACING = 20.f;
+
+    private:
+        struct Cell
+        {
+            int level;
+            glm::ivec3 index;
+
+            bool operator==(const Cell&) const = default;
+        };
+
+        struct CellHash
+        {
+            std::size_t operator()(const Cell& cell) const;
+        };
+
+    private:
+        // greatest error a record may be interpolated to, in Ward's combined distance and curvature measure;
+        // zero disables the cache
+        Real accuracy;
+        glm::vec3 camera = glm::vec3{ 0.f };
+        // angle subtended by one pixel
+        Real pixel_angle = 0.f;
+
+        std::vector<IrradianceRecord> records;
+        std::unordered_map<Cell, std::vector<std::uint32_t>, CellHash> cells;
+        int minimum_level = std::numeric_limits<int>::max();
+        int maximum_level = std::numeric_limits<int>::min();
+
+        mutable std::shared_mutex mutex;
+
+    public:
+        IrradianceCache(Real accuracy = 0.f)
+            : accuracy{ accuracy }
+        {
+        }
+
+    public:
+        // forgets every record, as when the view changes, and measures records from now on against the new camera
+        void reset(const glm::vec3& camera, Real pixel_angle);
+        // estimates irradiance from the records that cover position, if any do
+        bool lookup(const glm::vec3& position, const glm::vec3& normal, glm::vec3& irradiance) const;
+        // turns a gather about the frame basis, whose z axis is the normal, into a record
+        IrradianceRecord record(const glm::vec3& position, const glm::mat3& basis, const IrradianceGather& gather) const;
+        void insert(const IrradianceRecord& record);
+
+    public:
+        bool enabled() const
+        {
+            return accuracy > 0.f;
+        }
+
+        std::size_t size() const;
+    };
+}
+
+#endif
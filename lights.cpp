@@ -0,0 +1,399 @@
+#include <algorithm>
+
+#include "glm/gtc/constants.hpp"
+
+#include "lights.h"
+
+// lights.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // largest float below one, to keep a rescaled sample inside [0, 1)
+    constexpr auto ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+
+    ir::Real safe_sqrt(ir::Real value)
+    {
+        return glm::sqrt(glm::max(value, 0.f));
+    }
+
+    // cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+    ir::Real cos_subtract_clamped(ir::Real sin_a, ir::Real cos_a, ir::Real sin_b, ir::Real cos_b)
+    {
+        if (cos_a > cos_b)
+        {
+            return 1.f;
+        }
+
+        return cos_a * cos_b + sin_a * sin_b;
+    }
+
+    ir::Real sin_subtract_clamped(ir::Real sin_a, ir::Real cos_a, ir::Real sin_b, ir::Real cos_b)
+    {
+        if (cos_a > cos_b)
+        {
+            return 0.f;
+        }
+
+        return sin_a * cos_b - cos_a * sin_b;
+    }
+
+    // Rodrigues' rotation of vector by angle about a unit axis
+    glm::vec3 rotate(const glm::vec3& vector, ir::Real angle, const glm::vec3& axis)
+    {
+        const auto cosine = glm::cos(angle);
+        const auto sine = glm::sin(angle);
+        return vector * cosine + glm::cross(axis, vector) * sine + axis * glm::dot(axis, vector) * (1.f - cosine);
+    }
+}
+
+namespace ir
+{
+    Real LightBounds::importance(const glm::vec3& position, const glm::vec3& normal) const
+    {
+        const auto center = (minimum + maximum) / 2.f;
+        const auto radius = glm::length(maximum - minimum) / 2.f;
+
+        // clamped so that points inside or right next to the bounds do not blow up
+        const auto offset = position - center;
+        const auto length2 = glm::dot(offset, offset);
+        const auto distance2 = glm::max(length2, radius);
+
+        const auto incident = length2 > 0.f ? offset / glm::sqrt(length2) : axis;
+
+        auto cos_theta_w = glm::dot(axis, incident);
+        if (two_sided)
+        {
+            cos_theta_w = glm::abs(cos_theta_w);
+        }
+        const auto sin_theta_w = safe_sqrt(1.f - cos_theta_w * cos_theta_w);
+
+        // half-angle of the cone of directions from position that the bounding sphere of the bounds covers
+        const auto cos_theta_b = length2 <= radius * radius ? -1.f : safe_sqrt(1.f - radius * radius / length2);
+        const auto sin_theta_b = safe_sqrt(1.f - cos_theta_b * cos_theta_b);
+
+        // smallest angle between the incident direction and any emitting normal, after allowing for the extent of the bounds
+        const auto sin_theta_o = safe_sqrt(1.f - cos_theta_o * cos_theta_o);
+        const auto cos_theta_x = cos_subtract_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+        const auto sin_theta_x = sin_subtract_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+        const auto cos_theta_p = cos_subtract_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+
+        if (cos_theta_p <= cos_theta_e)
+        {
+            // every emitting surface is turned away from position
+            return 0.f;
+        }
+
+        auto importance = power * cos_theta_p / distance2;
+
+        if (normal != glm::vec3{ 0.f })
+        {
+            // and the receiving side, absolute since transmissive surfaces take light from behind too
+            const auto cos_theta_i = glm::abs(glm::dot(incident, normal));
+            const auto sin_theta_i = safe_sqrt(1.f - cos_theta_i * cos_theta_i);
+            importance *= cos_subtract_clamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+        }
+
+        return glm::max(importance, 0.f);
+    }
+
+    LightBounds unite(const LightBounds& a, const LightBounds& b)
+    {
+        if (a.power <= 0.f)
+        {
+            return b;
+        }
+
+        if (b.power <= 0.f)
+        {
+            return a;
+        }
+
+        auto result = LightBounds{};
+        result.minimum = glm::min(a.minimum, b.minimum);
+        result.maximum = glm::max(a.maximum, b.maximum);
+        result.power = a.power + b.power;
+        result.cos_theta_e = glm::min(a.cos_theta_e, b.cos_theta_e);
+        result.two_sided = a.two_sided || b.two_sided;
+
+        // a two-sided cone is the same about either end of its axis, so face b the same way as a before merging
+        const auto b_axis = (a.two_sided && b.two_sided && glm::dot(a.axis, b.axis) < 0.f) ? -b.axis : b.axis;
+
+        // smallest cone around both normal cones
+        const auto theta_a = glm::acos(glm::clamp(a.cos_theta_o, -1.f, 1.f));
+        const auto theta_b = glm::acos(glm::clamp(b.cos_theta_o, -1.f, 1.f));
+        const auto theta_d = glm::acos(glm::clamp(glm::dot(a.axis, b_axis), -1.f, 1.f));
+
+        if (glm::min(theta_d + theta_b, glm::pi<Real>()) <= theta_a)
+        {
+            result.axis = a.axis;
+            result.cos_theta_o = a.cos_theta_o;
+            return result;
+        }
+
+        if (glm::min(theta_d + theta_a, glm::pi<Real>()) <= theta_b)
+        {
+            result.axis = b_axis;
+            result.cos_theta_o = b.cos_theta_o;
+            return result;
+        }
+
+        const auto theta_o = (theta_a + theta_d + theta_b) / 2.f;
+        const auto between = glm::cross(a.axis, b_axis);
+
+        if (theta_o >= glm::pi<Real>() || glm::dot(between, between) <= 0.f)
+        {
+            result.axis = a.axis;
+            result.cos_theta_o = -1.f;
+            return result;
+        }
+
+        // swing a's axis toward b's until the cone just covers both
+        result.axis = glm::normalize(rotate(a.axis, theta_o - theta_a, glm::normalize(between)));
+        result.cos_theta_o = glm::cos(theta_o);
+        return result;
+    }
+
+    void LightHierarchy::build(const std::vector<Object*>& emitters, const std::vector<Real>& powers)
+    {
+        light_bounds.clear();
+        light_bounds.reserve(emitters.size());
+
+        auto volumes = std::vector<BoundingVolume>{};
+        auto centroids = std::vector<glm::vec3>{};
+        volumes.reserve(emitters.size());
+        centroids.reserve(emitters.size());
+
+        for (auto i = 0uz; i < emitters.size(); i++)
+        {
+            const auto object = emitters[i];
+            const auto volume = object->bounds();
+
+            auto bounds = LightBounds{};
+            bounds.minimum = volume.origin;
+            bounds.maximum = volume.origin + volume.size;
+            bounds.power = powers[i];
+            // area emitters radiate over the hemisphere about each normal
+            bounds.cos_theta_e = 0.f;
+
+            switch (object->type())
+            {
+                case PrimitiveType::TRIANGLE:
+                case PrimitiveType::QUADRILATERAL:
+                    // flat, with one normal; emitters are two-sided (see trace)
+                    bounds.axis = object->normal_of(object->centroid);
+                    bounds.cos_theta_o = 1.f;
+                    bounds.two_sided = true;
+                    break;
+
+                default:
+                    // closed shapes face every direction
+                    bounds.cos_theta_o = -1.f;
+                    break;
+            }
+
+            light_bounds.push_back(bounds);
+            volumes.push_back(volume);
+            centroids.push_back(volume.origin + volume.size / 2.f);
+        }
+
+        hierarchy.build(volumes, centroids);
+
+        node_bounds.assign(hierarchy.nodes.size(), LightBounds{});
+        parents.assign(hierarchy.nodes.size(), 0);
+        leaves.assign(emitters.size(), 0);
+
+        // children are always created after their parent, so a reverse sweep visits them first
+        for (auto i = hierarchy.nodes.size(); i-- > 0;)
+        {
+            const auto& node = hierarchy.nodes[i];
+
+            if (node.count > 0)
+            {
+                for (auto j = node.first; j < node.first + node.count; j++)
+                {
+                    const auto light = hierarchy.indices[j];
+                    node_bounds[i] = unite(node_bounds[i], light_bounds[light]);
+                    leaves[light] = static_cast<std::uint32_t>(i);
+                }
+            }
+            else
+            {
+                node_bounds[i] = unite(node_bounds[node.first], node_bounds[node.first + 1]);
+                parents[node.first] = static_cast<std::uint32_t>(i);
+                parents[node.first + 1] = static_cast<std::uint32_t>(i);
+            }
+        }
+    }
+
+    LightSample LightHierarchy::sample(const glm::vec3& position, const glm::vec3& normal, Real u) const
+    {
+        if (hierarchy.empty())
+        {
+            return LightSample{};
+        }
+
+        auto index = 0u;
+        auto probability = 1.f;
+
+        while (true)
+        {
+            const auto& node = hierarchy.nodes[index];
+
+            if (node.count == 0)
+            {
+                const auto left = node_bounds[node.first].importance(position, normal);
+                const auto right = node_bounds[node.first + 1].importance(position, normal);
+
+                if (left + right <= 0.f)
+                {
+                    return LightSample{};
+                }
+
+                // descend into one child and stretch the part of u that chose it back over [0, 1)
+                const auto p_left = left / (left + right);
+                if (u < p_left)
+                {
+                    index = node.first;
+                    u = glm::min(u / p_left, ONE_MINUS_EPSILON);
+                    probability *= p_left;
+                }
+                else
+                {
+                    index = node.first + 1;
+                    u = glm::min((u - p_left) / (1.f - p_left), ONE_MINUS_EPSILON);
+                    probability *= 1.f - p_left;
+                }
+
+                continue;
+            }
+
+            // leaves hold a handful of emitters, chosen between by their individual importance
+            auto total = 0.f;
+            for (auto i = node.first; i < node.first + node.count; i++)
+            {
+                total += light_bounds[hierarchy.indices[i]].importance(position, normal);
+            }
+
+            if (total <= 0.f)
+            {
+                return LightSample{};
+            }
+
+            auto cdf = 0.f;
+            auto chosen = LightSample{};
+            for (auto i = node.first; i < node.first + node.count; i++)
+            {
+                const auto light = hierarchy.indices[i];
+                const auto weight = light_bounds[light].importance(position, normal) / total;
+                if (weight <= 0.f)
+                {
+                    continue;
+                }
+
+                // the last emitter that can be picked absorbs any rounding at the top of the range
+                chosen = LightSample{ light, probability * weight };
+                cdf += weight;
+                if (u < cdf)
+                {
+                    break;
+                }
+            }
+
+            return chosen;
+        }
+    }
+
+    Real LightHierarchy::probability(const glm::vec3& position, const glm::vec3& normal, std::uint32_t index) const
+    {
+        if (index >= leaves.size())
+        {
+            return 0.f;
+        }
+
+        // the same choices as sample(), retraced from the emitter's leaf up to the root
+        const auto leaf = leaves[index];
+        const auto& node = hierarchy.nodes[leaf];
+
+        auto total = 0.f;
+        for (auto i = node.first; i < node.first + node.count; i++)
+        {
+            total += light_bounds[hierarchy.indices[i]].importance(position, normal);
+        }
+
+        if (total <= 0.f)
+        {
+            return 0.f;
+        }
+
+        auto probability = light_bounds[index].importance(position, normal) / total;
+
+        for (auto child = leaf; child != 0; child = parents[child])
+        {
+            const auto first = hierarchy.nodes[parents[child]].first;
+            const auto sibling = child == first ? first + 1 : first;
+
+            const auto chosen = node_bounds[child].importance(position, normal);
+            const auto other = node_bounds[sibling].importance(position, normal);
+
+            if (chosen + other <= 0.f)
+            {
+                return 0.f;
+            }
+
+            probability *= chosen / (chosen + other);
+        }
+
+        return probability;
+    }
+
+    void LightSampler::build(const std::vector<Object*>& emitters, const std::vector<Real>& powers)
+    {
+        switch (type)
+        {
+            case LightSamplerType::POWER:
+                table.build(powers);
+                break;
+
+            case LightSamplerType::HIERARCHY:
+                hierarchy.build(emitters, powers);
+                break;
+        }
+    }
+
+    LightSample LightSampler::sample(const glm::vec3& position, const glm::vec3& normal, Real u) const
+    {
+        switch (type)
+        {
+            case LightSamplerType::POWER:
+            {
+                if (table.empty())
+                {
+                    return LightSample{};
+                }
+
+                const auto index = table.sample(u);
+                return LightSample{ index, table.probability(index) };
+            }
+
+            case LightSamplerType::HIERARCHY:
+                return hierarchy.sample(position, normal, u);
+        }
+
+        return LightSample{};
+    }
+
+    Real LightSampler::probability(const glm::vec3& position, const glm::vec3& normal, std::uint32_t index) const
+    {
+        switch (type)
+        {
+            case LightSamplerType::POWER:
+                return index < table.size() ? table.probability(index) : 0.f;
+
+            case LightSamplerType::HIERARCHY:
+                return hierarchy.probability(position, normal, index);
+        }
+
+        return 0.f;
+    }
+}
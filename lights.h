@@ -0,0 +1,103 @@
+#ifndef IRRADIANCE_LIGHTS_H
+#define IRRADIANCE_LIGHTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+#include "hierarchy.h"
+#include "alias.h"
+#include "renderer.h"
+
+// lights.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // conservative summary of the light emitted by a group of emitters: where they are, how much they emit, and
+    // which way their surfaces face. emission leaves within cos_theta_e of a normal that is itself within
+    // cos_theta_o of axis
+    // https://pbr-book.org/4ed/Light_Sources/Light_Sampling#BVHLightSampling
+    struct LightBounds
+    {
+    public:
+        glm::vec3 minimum = glm::vec3{ std::numeric_limits<Real>::max() };
+        glm::vec3 maximum = glm::vec3{ -std::numeric_limits<Real>::max() };
+        Real power = 0.f;
+        glm::vec3 axis = glm::vec3{ 0.f, 0.f, 1.f };
+        Real cos_theta_o = 1.f;
+        Real cos_theta_e = 1.f;
+        // emits from both faces, so only the angle to the axis line matters
+        bool two_sided = false;
+
+    public:
+        // estimate of the light reaching a surface at position facing normal; zero only when none can
+        Real importance(const glm::vec3& position, const glm::vec3& normal) const;
+    };
+
+    LightBounds unite(const LightBounds& a, const LightBounds& b);
+
+    struct LightSample
+    {
+        std::uint32_t index = 0;
+        // of having picked index for this shading point; zero when no emitter can reach it
+        Real probability = 0.f;
+    };
+
+    // hierarchy over the emitters, walked from the root by choosing each child in proportion to its importance
+    // to the shading point, so nearby emitters facing it are picked far more often than distant or turned away ones
+    class LightHierarchy
+    {
+    private:
+        BoundingVolumeHierarchy hierarchy;
+        // per hierarchy node
+        std::vector<LightBounds> node_bounds;
+        std::vector<std::uint32_t> parents;
+        // per emitter
+        std::vector<LightBounds> light_bounds;
+        std::vector<std::uint32_t> leaves;
+
+    public:
+        void build(const std::vector<Object*>& emitters, const std::vector<Real>& powers);
+
+    public:
+        LightSample sample(const glm::vec3& position, const glm::vec3& normal, Real u) const;
+        // probability that sample() picks index for this shading point
+        Real probability(const glm::vec3& position, const glm::vec3& normal, std::uint32_t index) const;
+    };
+
+    enum class LightSamplerType
+    {
+        // in proportion to power alone, the same everywhere in the scene
+        POWER,
+        // by importance to each shading point through a LightHierarchy
+        HIERARCHY,
+    };
+
+    // chooses the emitter for next-event estimation
+    class LightSampler
+    {
+    private:
+        LightSamplerType type;
+        AliasTable table;
+        LightHierarchy hierarchy;
+
+    public:
+        LightSampler(LightSamplerType type = LightSamplerType::HIERARCHY)
+            : type{ type }
+        {
+        }
+
+    public:
+        // emitters and their powers are parallel; indices returned by sample() refer to them
+        void build(const std::vector<Object*>& emitters, const std::vector<Real>& powers);
+
+    public:
+        LightSample sample(const glm::vec3& position, const glm::vec3& normal, Real u) const;
+        Real probability(const glm::vec3& position, const glm::vec3& normal, std::uint32_t index) const;
+    };
+}
+
+#endif
@@ -14,15 +14,24 @@
 #include <numeric>
 #include <execution>
 #include <memory>
+#include <unordered_map>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #define GLM_FORCE_NEON
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
-#include "glm/gtc/random.hpp"
 #include "glm/gtx/norm.hpp"
 
 #include "utility.h"
+#include "random.h"
+#include "sampler.h"
+#include "alias.h"
+#include "lights.h"
+#include "environment.h"
+#include "adaptive.h"
+#include "irradiance.h"
+#include "radiance.h"
+#include "photons.h"
 #include "renderer.h"
 #include "scenes.h"
 #include "meshes.h"
@@ -38,6 +47,13 @@ static const glm::vec3 UP = glm::vec3{ 0.f, 1.f, 0.f };
 static constexpr Real SAMPLE_JITTER = .001f;
 
 static constexpr Real NONMETAL_REFLECTANCE = .04f;
+// smallest GGX alpha, which keeps mirror-like surfaces from having an infinitely peaked distribution
+static constexpr Real MINIMUM_ALPHA = .001f;
+// share of next-event samples aimed at the skybox when the scene also has emitters
+static constexpr Real ENVIRONMENT_PROBABILITY = .5f;
+static constexpr Real ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+// roughest reflection still sharp enough to focus a caustic, which next-event estimation through it would rarely find
+static constexpr Real CAUSTIC_ROUGHNESS = .2f;
 
 static constexpr Real BASE_ISO = 25.f;
 static constexpr Real REFERENCE_ISO = 4.f * BASE_ISO; // ISO100
@@ -53,10 +69,87 @@ static constexpr int FRAME_HISTORY = 5;
     static constexpr bool ENABLE_SKYBOX = false;
 #endif
 
+#define ENABLE_DLS
+
+// the one BSDF component each bounce scatters through, chosen at random in proportion to its Fresnel weight
+enum class Lobe
+{
+    METAL,
+    REFLECTION,
+    REFRACTION,
+    DIFFUSE,
+};
+
+// chance of scattering through each lobe at one surface, summing to one
+struct LobeWeights
+{
+    Real metal = 0.f;
+    Real reflection = 0.f;
+    Real refraction = 0.f;
+    Real diffuse = 0.f;
+
+    Lobe choose(Real random) const
+    {
+        return
+            random < metal ? Lobe::METAL :
+            random < metal + reflection ? Lobe::REFLECTION :
+            random < metal + reflection + refraction ? Lobe::REFRACTION :
+            Lobe::DIFFUSE;
+    }
+
+    Real of(Lobe lobe) const
+    {
+        switch (lobe)
+        {
+            case Lobe::METAL: return metal;
+            case Lobe::REFLECTION: return reflection;
+            case Lobe::REFRACTION: return refraction;
+            case Lobe::DIFFUSE: return diffuse;
+        }
+
+        return 0.f;
+    }
+};
+
+// where a path stands against the caustics in the photon map, which it must not find a second time by itself
+enum class Caustic
+{
+    NONE,
+    // scattered diffusely last
+    DIFFUSE,
+    // scattered diffusely and then only off near-specular surfaces, so any emitter it finds now lights a caustic
+    SPECULAR,
+};
+
+// how the ray being traced left the previous surface, needed to weight any emitter it hits against next-event estimation
+struct Scattering
+{
+    glm::vec3 position = glm::vec3{ 0.f };
+    glm::vec3 normal = glm::vec3{ 0.f };
+    // solid angle density of the scattered direction; zero for camera rays and lobes without next-event estimation
+    Real pdf = 0.f;
+    // part of the gather for a new irradiance record, whose paths must not in turn wait on records of their own
+    bool gathering = false;
+    // surfaces the path scattered off before this ray
+    int depth = 0;
+    Caustic caustic = Caustic::NONE;
+};
+
 
 int _bounces = 2;
 int _samples = 5;
+// relative error under which a pixel stops receiving samples; zero samples every pixel evenly
+Real _noise = 0.f;
+// greatest interpolation error of the irradiance cache; zero traces every diffuse bounce as a path of its own
+Real _irradiance = 0.f;
+// bounce from which paths may end in the radiance cache; zero disables it
+int _radiance = 0;
+// caustic photons traced per frame; zero disables the photon map
+int _photons = 0;
 int _captures = 1;
+std::uint64_t _seed = 0;
+SamplerType _sampler = SamplerType::SOBOL;
+LightSamplerType _lights = LightSamplerType::HIERARCHY;
 
 template<typename T, std::size_t N>
 class CircularBuffer
@@ -126,6 +219,8 @@ private:
     Real yaw_degrees = 0.f;
     Real pitch_degrees = 0.f;
     int accumulated_frames = 1;
+    // frames rendered since startup, never reset, so that every frame draws fresh random numbers
+    std::uint64_t frame_index = 0;
     Ray* rays = nullptr;
     bool enable_dof = false;
     Real focal_distance = std::numeric_limits<Real>::infinity();
@@ -133,6 +228,8 @@ private:
     Real ISO = REFERENCE_ISO;
     Real shutter_speed = 1 / 60.f;
     bool enable_ui = true;
+    // shows how many samples each pixel took this frame instead of the image
+    bool enable_sample_view = false;
 
     glm::vec3* frame_buffer = nullptr;
     glm::vec3* staging_buffer = nullptr;
@@ -141,16 +238,54 @@ private:
 
     std::vector<int> index_buffer;
 
+    SampleAllocator sample_allocator;
+
+    IrradianceCache irradiance_cache{ _irradiance };
+
+    RadianceCache radiance_cache{ _radiance > 0 };
+    // paths end in the radiance cache where they can; off, it keeps learning while the unbiased image is shown
+    bool enable_radiance_cache = true;
+
+    PhotonMap photon_map{ static_cast<std::size_t>(_photons) };
+
 public:
+    // where a ray finds an emitter: its authoring object, or the face for one loaded without any, within the instance it was hit through
+    struct EmitterKey
+    {
+        std::uint32_t instance = 0;
+        const Object* object = nullptr;
+        std::uint32_t face = RayIntersection::NO_FACE;
+
+        bool operator==(const EmitterKey&) const = default;
+    };
+
+    struct EmitterKeyHash
+    {
+        std::size_t operator()(const EmitterKey& key) const
+        {
+            return mix(std::hash<const Object*>{}(key.object) ^ (std::uint64_t{ key.instance } << 32 | key.face));
+        }
+    };
+
     struct Emitter
     {
         Object* object = nullptr;
+        // may differ from the object's own material when its instance overrides it
+        MaterialId material = NO_MATERIAL;
         Real power = 0.f;
-        Real probability = 0.f;
+        EmitterKey key;
     };
 
-    std::vector<MeshInstance> scene_instances;
+    Scene scene;
     std::vector<Emitter> emissive_objects;
+    // picks an index into emissive_objects for next-event estimation, weighted by compute_emissivity
+    LightSampler light_sampler;
+    // index into emissive_objects of each emitter where it can be hit, for finding the light pdf of emitters hit by chance
+    std::unordered_map<EmitterKey, std::uint32_t, EmitterKeyHash> emitter_indices;
+    // picks an index into emissive_objects for each photon, in proportion to the power it emits
+    AliasTable photon_emitters;
+    // skybox brightness distribution for next-event estimation toward it
+    EnvironmentMap environment;
 
 public:
     std::string capture_screenshot()
@@ -171,7 +306,7 @@ public:
             {
                 const auto index = x + y * ScreenWidth();
 
-                const auto original = frame_buffer[x + y * ScreenWidth()] / static_cast<Real>(accumulated_frames);
+                const auto original = frame_buffer[x + y * ScreenWidth()];
 
                 const auto color = RGB
                 { 
@@ -193,21 +328,18 @@ public:
 
     RayIntersection compute_nearest_intersection(const Ray& ray)
     {
-        auto nearest_intersection = RayIntersection{};
+        return scene.intersect(ray);
+    }
 
-        for (const auto& instance : scene_instances)
+    Real compute_transmittance(const Ray& ray, Real t_max)
+    {
+        // a scene without media can only block light outright, so the any-hit test stops at the first blocker
+        if (!scene.media)
         {
-            #pragma message("TODO OPTIMIZE BY TRANSFORMING RAY ONE PER INSTANCE NOT PER SUB-OBJECT")
-
-            const auto intersection = instance.intersect(ray);
-
-            if (intersection.hit && intersection.depth < nearest_intersection.depth)
-            {
-                nearest_intersection = intersection;
-            }
+            return scene.occluded(ray, t_max) ? 0.f : 1.f;
         }
 
-        return nearest_intersection;
+        return scene.transmittance(ray, t_max);
     }
 
     glm::vec3 compute_direction() const
@@ -243,39 +375,88 @@ public:
 
     glm::vec2 compute_skybox_uv_coordinates(const glm::vec3& direction) const
     {
-        const auto theta = glm::atan(direction.z, direction.x);
-        const auto phi = glm::acos(-direction.y); 
+        return environment_uv(direction);
+    }
+
+    glm::vec3 compute_skybox_radiance(const glm::vec3& direction) const
+    {
+        const auto uv = compute_skybox_uv_coordinates(direction);
+        const auto sample = skybox->Sample(uv.x, uv.y);
+        return glm::vec3{ sample.r / 255.f, sample.g / 255.f, sample.b / 255.f };
+    }
+
+    // chance that next-event estimation aims at the skybox rather than at an emitter
+    Real compute_environment_probability() const
+    {
+        if (!ENABLE_SKYBOX || environment.empty())
+        {
+            return 0.f;
+        }
 
-        auto u = (theta + glm::pi<Real>()) / (2.f * glm::pi<Real>());
-        auto v = phi / glm::pi<Real>();
+        return emissive_objects.empty() ? 1.f : ENVIRONMENT_PROBABILITY;
+    }
 
-        u = 1.f - u;
+    // angle subtended by one pixel at the centre of the view
+    Real compute_pixel_angle() const
+    {
+        return 2.f * glm::tan(glm::radians(fov_degrees) * .5f) / static_cast<Real>(ScreenHeight());
+    }
 
-        return { u, v };
+    // whether a hit is a scattering event inside a medium rather than on a surface
+    bool compute_medium(const RayIntersection& intersection) const
+    {
+        const auto type = intersection.object ? intersection.object->type() : PrimitiveType::TRIANGLE;
+        return type == PrimitiveType::COLLOID || type == PrimitiveType::VOLUME;
+    }
+
+    // whether the radiance leaving a hit is much the same in every direction, as the radiance cache assumes
+    bool compute_cacheable(const RayIntersection& intersection) const
+    {
+        // scattering events inside a medium have no surface to key a cell on
+        if (compute_medium(intersection))
+        {
+            return false;
+        }
+
+        const auto& material = *intersection.material;
+        return material.transmission < .5f && (material.metallicity < .5f || material.roughness > .5f);
     }
 
     Real compute_emissivity(const Emitter& emitter)
     {
-        return emitter.object->area * glm::length(emitter.object->material.emission);
+        return emitter.object->area * glm::length(scene.materials[emitter.material].emission);
     };
 
     #define INTERNAL_REVALIDATE(x, y) do { if (glm::isinf(x) || glm::isnan(x)) { x = y; } } while (0)
     #define REVALIDATE(x) INTERNAL_REVALIDATE(x, 0.f)
 
-    Real compute_GGX_D(const glm::vec3& half_vector, const glm::vec3& normal, Real roughness)
+    // GGX widths along the tangent and bitangent of compute_basis(), stretched apart by anisotropy
+    // https://media.disneyanimation.com/uploads/production/publication_asset/48/asset/s2012_pbs_disney_brdf_notes_v3.pdf
+    glm::vec2 compute_alpha(const PBRMaterial& material)
     {
-        // NOTE: I have no idea why this extra epsilon is necessary, but otherwise things with very low roughness 
-        // end up basically black and colorless. TODO: Ask Shaeffer?
-        const auto roughness4 = roughness * roughness * roughness * roughness + .1f;
+        // perceptual roughness squared, floored so that perfectly smooth surfaces keep a finite (if very narrow) distribution
+        const auto alpha = material.roughness * material.roughness;
+        const auto aspect = glm::sqrt(1.f - .9f * glm::clamp(material.anisotropy, 0.f, 1.f));
 
-        const auto angle = glm::max(glm::dot(normal, half_vector), 0.f);
-        const auto angle2 = angle * angle;
+        return glm::max(glm::vec2{ alpha / aspect, alpha * aspect }, glm::vec2{ MINIMUM_ALPHA });
+    }
 
-        const auto scalar = (angle2 * (roughness4 - 1.f) + 1.f);
-        auto denominator = glm::pi<Real>() * scalar * scalar;
+    // the microfacet functions below all work in the shading frame of compute_basis(), where the normal is +z
+
+    Real compute_GGX_D(const glm::vec3& half_vector, const glm::vec2& alpha)
+    {
+        if (half_vector.z <= 0.f)
+        {
+            return 0.f;
+        }
+
+        const auto stretched = glm::vec3{ half_vector.x / alpha.x, half_vector.y / alpha.y, half_vector.z };
+        const auto length2 = glm::dot(stretched, stretched);
+
+        auto denominator = glm::pi<Real>() * alpha.x * alpha.y * length2 * length2;
         REVALIDATE(denominator);
 
-        return roughness4 / denominator;
+        return 1.f / denominator;
     }
 
     glm::vec3 compute_fresnel_F(const glm::vec3& F0, Real cosine)
@@ -284,31 +465,283 @@ public:
         return F0 + (1.f - F0) * glm::pow(1.f - cosine, 5.f);
     }
 
-    Real compute_smith_G(const glm::vec3& light, const glm::vec3& view, const glm::vec3& normal, Real roughness)
+    // Smith auxiliary function, the masked fraction of microfacets seen from direction relative to those facing it
+    // https://jcgt.org/published/0003/02/03/
+    Real compute_smith_lambda(const glm::vec3& direction, const glm::vec2& alpha)
     {
-        //  https://schuttejoe.github.io/post/ggximportancesamplingpart2/
+        const auto cosine2 = direction.z * direction.z;
+        const auto projected = alpha.x * alpha.x * direction.x * direction.x + alpha.y * alpha.y * direction.y * direction.y;
 
-        const auto light_angle = glm::max(glm::dot(normal, light), 0.f);
-        const auto view_angle = glm::max(glm::dot(normal, view), 0.f);
+        auto lambda = .5f * (glm::sqrt(1.f + projected / cosine2) - 1.f);
+        REVALIDATE(lambda);
 
-        const auto k = (roughness + 1.f) * (roughness + 1.f) / 8.f;
+        return lambda;
+    }
 
-        auto G1_light = light_angle / (light_angle * (1.f - k) + k);
-        REVALIDATE(G1_light);
-        auto G1_view = view_angle / (view_angle * (1.f - k) + k);
-        REVALIDATE(G1_view);
+    Real compute_smith_G1(const glm::vec3& direction, const glm::vec2& alpha)
+    {
+        return 1.f / (1.f + compute_smith_lambda(direction, alpha));
+    }
 
-        return G1_light * G1_view;
+    // height-correlated masking and shadowing
+    Real compute_smith_G(const glm::vec3& light, const glm::vec3& view, const glm::vec2& alpha)
+    {
+        return 1.f / (1.f + compute_smith_lambda(light, alpha) + compute_smith_lambda(view, alpha));
     }
 
-    glm::vec3 trace(Ray& ray, int bounces, RayIntersection& output_intersection)
+    // Cook-Torrance microfacet reflection toward light for a surface seen from view
+    glm::vec3 compute_GGX(const glm::vec3& light, const glm::vec3& view, const glm::vec2& alpha, const glm::vec3& F0)
     {
-        if (bounces <= 0)
+        if (light.z <= 0.f || view.z <= 0.f)
         {
             return glm::vec3{ 0.f };
         }
 
-        // TODO: bounding volume hierarchy acceleration structure
+        const auto H = glm::normalize(light + view);
+
+        const auto D = compute_GGX_D(H, alpha);
+        const auto F = compute_fresnel_F(F0, glm::max(0.f, glm::dot(H, view)));
+        const auto G = compute_smith_G(light, view, alpha);
+
+        return (D * G * F) / (4.f * light.z * view.z);
+    }
+
+    // solid angle density of reflecting view about a half vector from sample_GGX()
+    Real compute_GGX_pdf(const glm::vec3& light, const glm::vec3& view, const glm::vec2& alpha)
+    {
+        if (light.z <= 0.f || view.z <= 0.f)
+        {
+            return 0.f;
+        }
+
+        const auto H = glm::normalize(light + view);
+
+        // visible normal density G1(v) max(0, v . h) D(h) / v.z, and reflection about the half vector divides by 4 (v . h)
+        return compute_smith_G1(view, alpha) * compute_GGX_D(H, alpha) / (4.f * view.z);
+    }
+
+    // half vector drawn from the normals visible from view, so that none are wasted on facets turned away from it
+    // https://jcgt.org/published/0007/04/01/
+    glm::vec3 sample_GGX(const glm::vec2& u, const glm::vec3& view, const glm::vec2& alpha)
+    {
+        // stretch the view so that the distribution becomes a hemisphere of unit roughness
+        const auto stretched = glm::normalize(glm::vec3{ alpha.x * view.x, alpha.y * view.y, glm::max(view.z, 0.f) });
+
+        const auto length2 = stretched.x * stretched.x + stretched.y * stretched.y;
+        const auto T1 = length2 > 0.f 
+            ? glm::vec3{ -stretched.y, stretched.x, 0.f } / glm::sqrt(length2) 
+            : glm::vec3{ 1.f, 0.f, 0.f };
+        const auto T2 = glm::cross(stretched, T1);
+
+        // uniform point on the disk, squashed onto the part of it that the projected hemisphere covers
+        const auto radius = glm::sqrt(u.x);
+        const auto phi = 2.f * glm::pi<Real>() * u.y;
+        const auto t1 = radius * glm::cos(phi);
+        const auto blend = .5f * (1.f + stretched.z);
+        const auto t2 = (1.f - blend) * glm::sqrt(glm::max(0.f, 1.f - t1 * t1)) + blend * radius * glm::sin(phi);
+
+        const auto hemisphere = t1 * T1 + t2 * T2 + glm::sqrt(glm::max(0.f, 1.f - t1 * t1 - t2 * t2)) * stretched;
+
+        // and unstretch the normal found there
+        return glm::normalize(glm::vec3{ alpha.x * hemisphere.x, alpha.y * hemisphere.y, glm::max(hemisphere.z, 0.f) });
+    }
+
+    // right-handed tangent frame whose z axis is normal, so that it is a rotation and cross products taken in it,
+    // such as the axes of the irradiance cache's rotation gradients, carry over to world space unchanged
+    glm::mat3 compute_basis(const glm::vec3& normal)
+    {
+        auto tangent = glm::normalize(glm::cross(normal, glm::vec3{ 0.f, 0.f, 1.f }));
+        if (glm::length2(tangent) < .001f || glm::any(glm::isnan(tangent)))
+        {
+            tangent = glm::normalize(glm::cross(normal, glm::vec3{ 0.f, 1.f, 0.f }));
+        }
+
+        const auto bitangent = glm::normalize(glm::cross(normal, tangent));
+
+        return glm::mat3{ tangent, bitangent, normal };
+    }
+
+    // shares of the lobes at a surface whose Fresnel reflectance toward the viewer is F
+    LobeWeights compute_lobe_weights(const PBRMaterial& mat, const glm::vec3& F)
+    {
+        const auto metal_probability = mat.metallicity;
+        const auto reflection_probability = (1.f - mat.metallicity) * glm::compMax(F) + mat.metallicity;
+        const auto refraction_probability = (1.f - mat.metallicity) * (1.f - glm::compMax(F)) * mat.transmission;
+        const auto diffuse_probability = (1.f - mat.metallicity) * (1.f - glm::compMax(F)) * (1.f - mat.transmission);
+
+        const auto total = metal_probability + reflection_probability + refraction_probability + diffuse_probability;
+
+        return LobeWeights
+        {
+            .metal = metal_probability / total,
+            .reflection = reflection_probability / total,
+            .refraction = refraction_probability / total,
+            .diffuse = diffuse_probability / total,
+        };
+    }
+
+    // whether a lobe scatters sharply enough to focus light into a caustic
+    bool compute_specular(Lobe lobe, const PBRMaterial& mat)
+    {
+        return lobe == Lobe::REFRACTION || (lobe != Lobe::DIFFUSE && mat.roughness < CAUSTIC_ROUGHNESS);
+    }
+
+    // BSDF of the chosen lobe toward light, for a surface seen from view, both in the shading frame.
+    // refraction can only be evaluated along the direction it sampled, so it takes no part in next-event estimation
+    glm::vec3 compute_BSDF(Lobe lobe, const glm::vec3& light, const glm::vec3& view, const glm::vec2& alpha, const glm::vec3& F0, const glm::vec3& albedo, const PBRMaterial& mat)
+    {
+        switch (lobe)
+        {
+            case Lobe::METAL: return compute_GGX(light, view, alpha, F0) * albedo;
+            case Lobe::REFLECTION: return compute_GGX(light, view, alpha, F0) * glm::vec3{ mat.transmission };
+            case Lobe::REFRACTION: return glm::vec3{ 0.f };
+            case Lobe::DIFFUSE: return albedo / glm::pi<Real>();
+        }
+
+        return glm::vec3{ 0.f };
+    }
+
+    // solid angle density with which the lobe itself samples light
+    Real compute_BSDF_pdf(Lobe lobe, const glm::vec3& light, const glm::vec3& view, const glm::vec2& alpha)
+    {
+        switch (lobe)
+        {
+            case Lobe::METAL:
+            case Lobe::REFLECTION: return compute_GGX_pdf(light, view, alpha);
+            case Lobe::REFRACTION: return 0.f;
+            case Lobe::DIFFUSE: return glm::max(light.z, 0.f) / glm::pi<Real>();
+        }
+
+        return 0.f;
+    }
+
+    // turns ray into the one scattered through the lobe at the intersection, and returns what it carries back, f cos / pdf.
+    // pdf is the solid angle density of the new direction, left zero for refraction
+    glm::vec3 compute_scattering(Ray& ray, const RayIntersection& intersection, const glm::vec3& normal, bool is_front_face, Lobe lobe,
+        const glm::mat3& basis, const glm::vec2& alpha, const glm::vec3& F0, const glm::vec3& albedo, const glm::vec2& u, Real& pdf)
+    {
+        const auto& mat = *intersection.material;
+        const auto to_local = glm::transpose(basis);
+        const auto view = to_local * -ray.direction;
+
+        switch (lobe)
+        {
+            case Lobe::METAL:
+            case Lobe::REFLECTION:
+            {
+                // metallic or dielectric reflection about a visible microfacet normal
+                const auto half_vector = basis * sample_GGX(u, view, alpha);
+
+                ray.origin = intersection.position + normal * .001f;
+                ray.direction = glm::normalize(glm::reflect(ray.direction, half_vector));
+                break;
+            }
+
+            case Lobe::REFRACTION:
+            {
+                // dielectric refraction through a visible microfacet normal, so rough glass blurs by the same GGX lobe.
+                // the normal already faces the incoming ray, so only which face was hit says whether it enters or leaves
+                const auto half_vector = basis * sample_GGX(u, view, alpha);
+
+                const auto eta = is_front_face
+                    ? (1.f / mat.refraction_index)
+                    : mat.refraction_index;
+
+                auto refraction = glm::refract(ray.direction, half_vector, eta);
+
+                if (glm::length2(refraction) < .001f)
+                {
+                    // total internal reflection
+                    refraction = glm::reflect(ray.direction, half_vector);
+                    ray.origin = intersection.position + normal * .001f;
+                }
+                else
+                {
+                    // NOTE: IMPORTANT--OFFSET IS A NEGATIVE MARGIN TO AVOID SELF-INTERSECTION FOR REFRACTION RAY
+                    ray.origin = intersection.position - normal * .001f;
+                }
+
+                ray.direction = glm::normalize(refraction);
+
+                // Beer-Lambert attenuation (re-using albedo as absorption)
+                const auto attenuation_distance = intersection.exit - intersection.depth;
+                const auto attenuation = glm::exp(-mat.albedo * attenuation_distance);
+
+                // visible normals already account for masking toward the viewer, leaving only shadowing on the way out
+                pdf = 0.f;
+                return attenuation * compute_smith_G1(to_local * ray.direction, alpha);
+            }
+
+            case Lobe::DIFFUSE:
+            {
+                // diffuse scattering
+
+                // cosine-weighted hemisphere random sampling per lambertian BRDF
+                // heavily modified from the cosine distribution method plus re-basis using orthonormal space
+                // https://www.rorydriscoll.com/2009/01/07/better-sampling/
+
+                const auto local_coodinates = sample_cosine_hemisphere(u);
+                const auto world_coordinates = basis * local_coodinates;
+
+                ray.origin = intersection.position + normal * .001f;
+                ray.direction = glm::normalize(world_coordinates);
+                break;
+            }
+        }
+
+        const auto light = to_local * ray.direction;
+        pdf = compute_BSDF_pdf(lobe, light, view, alpha);
+
+        return pdf > 0.f
+            ? compute_BSDF(lobe, light, view, alpha, F0, albedo, mat) * glm::max(glm::dot(normal, ray.direction), 0.f) / pdf
+            : glm::vec3{ 0.f };
+    }
+
+    // multiple importance sampling weight of a strategy with density pdf against one with density other
+    // https://graphics.stanford.edu/courses/cs348b-03/papers/veach-chapter9.pdf
+    Real compute_power_heuristic(Real pdf, Real other)
+    {
+        const auto pdf2 = pdf * pdf;
+        const auto other2 = other * other;
+
+        auto weight = pdf2 / (pdf2 + other2);
+        INTERNAL_REVALIDATE(weight, 1.f);
+
+        return weight;
+    }
+
+    // solid angle density with which next-event estimation from the scattering point would have found this point of an emitter
+    Real compute_light_pdf(const Scattering& scattering, const RayIntersection& intersection, const Ray& ray)
+    {
+        const auto key = EmitterKey
+        {
+            .instance = intersection.instance,
+            .object = intersection.object,
+            .face = intersection.object ? RayIntersection::NO_FACE : intersection.face,
+        };
+
+        const auto found = emitter_indices.find(key);
+        if (found == emitter_indices.end())
+        {
+            return 0.f;
+        }
+
+        const auto& emitter = emissive_objects[found->second];
+
+        // the scattered ray starts where next-event estimation would have sampled from
+        const auto probability = (1.f - compute_environment_probability()) * light_sampler.probability(scattering.position, scattering.normal, found->second);
+        auto pdf = probability * emitter.object->pdf_from(ray.origin, intersection.position);
+        REVALIDATE(pdf);
+
+        return pdf;
+    }
+
+    glm::vec3 trace(Ray& ray, int bounces, RayIntersection& output_intersection, Sampler& sampler, const Scattering& scattering = Scattering{})
+    {
+        if (bounces <= 0)
+        {
+            return glm::vec3{ 0.f };
+        }
 
         const auto nearest_intersection = compute_nearest_intersection(ray);
         output_intersection = nearest_intersection;
@@ -321,34 +754,63 @@ public:
             // for testing only
             //std::cout << "Hit at depth: " << intersection.depth << "\n";
 
-            if (nearest_intersection.material.emission != glm::vec3{ 0.f })
+            if (nearest_intersection.material->emission != glm::vec3{ 0.f })
             {
-                // emissive surfaces terminate bouncing
-                return nearest_intersection.material.emission;
+                // emissive surfaces terminate bouncing.
+                // light found at the end of a caustic is already held by the photon map
+                if (scattering.caustic == Caustic::SPECULAR && photon_map.enabled())
+                {
+                    return glm::vec3{ 0.f };
+                }
+
+                // next-event estimation from the previous bounce could have found this same light, so the two share it
+                auto weight = 1.f;
+
+            #ifdef ENABLE_DLS
+                if (scattering.pdf > 0.f)
+                {
+                    weight = compute_power_heuristic(scattering.pdf, compute_light_pdf(scattering, nearest_intersection, ray));
+                }
+            #endif
+
+                return nearest_intersection.material->emission * weight;
             }
 
-            auto albedo = nearest_intersection.material.albedo;
+            auto albedo = nearest_intersection.material->albedo;
 
-            if (nearest_intersection.material.texture)
+            if (nearest_intersection.material->texture)
             {
                 const auto& uv = nearest_intersection.uv;
-                const auto sample = nearest_intersection.material.texture->Sample(uv.x, uv.y, nearest_intersection.position);
+                const auto sample = nearest_intersection.material->texture->Sample(uv.x, uv.y, nearest_intersection.position);
                 albedo = glm::vec3{ sample.r / 255.f, sample.g / 255.f, sample.b / 255.f };
             }
+
+            // whatever a medium absorbed on the way to a scattering event inside it
+            albedo *= nearest_intersection.attenuation;
                 
             // ensure normal is relative to the front face
             auto normal = nearest_intersection.normal;
             const bool is_front_face = glm::dot(normal, ray.direction) < 0.f;
             normal = is_front_face ? normal : -normal;
 
-            // ensure random sample hits hemisphere above the front face surface normal
-            auto random_in_unit_sphere = glm::sphericalRand(1.f);
-            if (glm::dot(random_in_unit_sphere, normal) < 0.f)
+            // RADIANCE CACHE PATH TERMINATION
+            const auto cacheable = radiance_cache.enabled() && compute_cacheable(nearest_intersection);
+            if (cacheable && enable_radiance_cache && scattering.depth >= _radiance)
             {
-                random_in_unit_sphere = -random_in_unit_sphere;
+                auto radiance = glm::vec3{ 0.f };
+                if (radiance_cache.lookup(nearest_intersection.position, normal, radiance))
+                {
+                    return radiance;
+                }
             }
 
-            const auto& mat = nearest_intersection.material;
+            // every bounce draws the same dimensions in the same order: lobe, direction, then emitter and light point
+            const auto random = sampler.next_1d();
+            const auto direction_sample = sampler.next_2d();
+            const auto emitter_sample = sampler.next_1d();
+            const auto light_u = sampler.next_2d();
+
+            const auto& mat = *nearest_intersection.material;
 
             const auto normal_angle = glm::clamp(glm::dot(normal, ray.direction), 0.f, 1.f);
             
@@ -356,213 +818,431 @@ public:
             const auto F0 = glm::mix(glm::vec3{ NONMETAL_REFLECTANCE }, albedo, mat.metallicity);
             const auto F = compute_fresnel_F(F0, 1.f - normal_angle);
 
-            const auto metal_probability = mat.metallicity;
-            const auto reflection_probability = (1.f - mat.metallicity) * glm::compMax(F) + mat.metallicity;
-            const auto refraction_probability = (1.f - mat.metallicity) * (1.f - glm::compMax(F)) * mat.transmission;
-            const auto diffuse_probability = (1.f - mat.metallicity) * (1.f - glm::compMax(F)) * (1.f - mat.transmission);
+            const auto weights = compute_lobe_weights(mat, F);
+            const auto lobe = weights.choose(random);
+            const auto weight = weights.of(lobe);
+
+            // media have no surface for photons to land on, so caustics only begin from diffuse surfaces
+            const auto medium = compute_medium(nearest_intersection);
+            const auto caustic =
+                lobe == Lobe::DIFFUSE && !medium ? Caustic::DIFFUSE :
+                scattering.caustic != Caustic::NONE && compute_specular(lobe, mat) && !medium ? Caustic::SPECULAR :
+                Caustic::NONE;
 
-            const auto total = metal_probability + reflection_probability + refraction_probability + diffuse_probability;
+            // microfacet lobes are evaluated in the shading frame, where the (front face) normal is +z
+            const auto basis = compute_basis(normal);
+            const auto to_local = glm::transpose(basis);
+            const auto alpha = compute_alpha(mat);
+
+            const auto view = to_local * -ray.direction;
+
+            auto evaluate = [&](const glm::vec3& light)
+            {
+                return compute_BSDF(lobe, to_local * light, view, alpha, F0, albedo, mat);
+            };
 
-            const auto metal_weight = metal_probability / total;
-            const auto reflection_weight = reflection_probability / total;
-            const auto refraction_weight = refraction_probability / total;
-            const auto diffuse_weight = diffuse_probability / total;
+            auto density = [&](const glm::vec3& light)
+            {
+                return compute_BSDF_pdf(lobe, to_local * light, view, alpha);
+            };
 
-            const auto random = glm::linearRand(0.f, 1.f);
+            // what the continuing path carries back is f cos / pdf for the direction just sampled
+            auto scattered_pdf = 0.f;
+            const auto absorption = compute_scattering(ray, nearest_intersection, normal, is_front_face, lobe, basis, alpha, F0, albedo, direction_sample, scattered_pdf);
 
-            auto absorption = glm::vec3{ 1.f };
-            auto weight = 1.f;
+            auto path = glm::vec3{ 0.f };
 
-            const auto reflection = glm::reflect(ray.direction, normal);
+            #ifdef ENABLE_DLS
 
-            auto shade_ggx = [&]()
+            // DIRECT LIGHT SAMPLING PATH TERMINATION
+            const auto environment_probability = compute_environment_probability();
+            if ((environment_probability > 0.f || !emissive_objects.empty()) && lobe != Lobe::REFRACTION)
             {
-                const auto V = -ray.direction;
-                const auto R = reflection; 
-                const auto H = glm::normalize(R + V);
+                // next-event estimation direct light sampling per bounce
+                // https://www.cg.tuwien.ac.at/sites/default/files/course/4411/attachments/08_next%20event%20estimation.pdf
+                auto light_ray = Ray
+                {
+                    .origin = nearest_intersection.position + normal * .001f,
+                };
 
-                const auto D = compute_GGX_D(H, normal, mat.roughness);
-                const auto F = compute_fresnel_F(F0, glm::max(0.f, glm::dot(H, V)));
-                const auto G = compute_smith_G(R, V, normal, mat.roughness);
+                auto radiance = glm::vec3{ 0.f };
+                auto light_pdf = 0.f;
+                auto light_distance = std::numeric_limits<Real>::max();
 
-                const auto reflection_angle = glm::max(0.f, glm::dot(normal, R));
-                const auto view_angle = glm::max(0.f, glm::dot(normal, V));
+                if (emitter_sample < environment_probability)
+                {
+                    // the skybox is infinitely far away, so only its direction matters and anything in the way blocks it
+                    const auto environment_sample = environment.sample(light_u);
 
-                auto ggx = (D * G * F) / (4.f * reflection_angle * view_angle);
-                REVALIDATE(ggx.x);
-                REVALIDATE(ggx.y);
-                REVALIDATE(ggx.z);
+                    light_ray.direction = environment_sample.direction;
+                    radiance = compute_skybox_radiance(environment_sample.direction);
+                    light_pdf = environment_probability * environment_sample.pdf;
+                }
+                else
+                {
+                    // what is left of the same number picks the emitter
+                    const auto u = glm::min((emitter_sample - environment_probability) / (1.f - environment_probability), ONE_MINUS_EPSILON);
 
-                return ggx;
-            };
+                    // emitters are picked by how much light they can bring to this point, which may be none at all
+                    const auto light_choice = light_sampler.sample(nearest_intersection.position, normal, u);
+                    const auto& sampled_emitter = emissive_objects[light_choice.index];
+
+                    // direct light importance sampling https://raytracing.github.io/books/RayTracingTheRestOfYourLife.html#samplinglightsdirectly/
+                    // aimed from this point, so that the point lands on the part of the emitter facing it wherever the shape allows
+                    const auto light_sample = sampled_emitter.object->sample_from(light_ray.origin, light_u);
 
-            if (random < metal_weight)
+                    auto light_direction = light_sample.position - light_ray.origin;
+                    const auto distance2 = glm::length2(light_direction);
+                    light_direction = glm::normalize(light_direction);
+                    light_ray.direction = light_direction;
+
+                    // emitters are two-sided (see the emission check above), so either face may be the visible one
+                    const auto light_cosine = glm::clamp(glm::abs(glm::dot(light_sample.normal, light_direction)), 0.f, 1.f);
+
+                    // light reaching this point through a caustic is the photon map's to find, as it is for the scattered ray
+                    if (light_cosine > 0.f && !(caustic == Caustic::SPECULAR && photon_map.enabled()))
+                    {
+                        radiance = scene.materials[sampled_emitter.material].emission;
+                        // solid angle density of the point, times the chance of having picked this emitter at all
+                        light_pdf = (1.f - environment_probability) * light_choice.probability * light_sample.pdf;
+                    }
+
+                    // stop just short of the sample so the emitter itself never counts as its own blocker
+                    light_distance = glm::sqrt(distance2) - .001f;
+                }
+
+                const auto light_direction = light_ray.direction;
+                const auto normal_cosine = glm::clamp(glm::dot(normal, light_direction), 0.f, 1.f);
+
+                // media along the way dim the light rather than block it outright
+                const auto transmittance = light_pdf > 0.f && normal_cosine > 0.f ? compute_transmittance(light_ray, light_distance) : 0.f;
+                if (transmittance > 0.f)
+                {
+                    // the chosen lobe could also have scattered toward this light, so the two strategies share it,
+                    // except on the last bounce where the scattered ray is never traced and this is the only way to find it
+                    const auto mis_weight = bounces > 1 ? compute_power_heuristic(light_pdf, density(light_direction)) : 1.f;
+
+                    auto result = evaluate(light_direction) * radiance * transmittance * normal_cosine * mis_weight / (weight * light_pdf);
+                    REVALIDATE(result.r);
+                    REVALIDATE(result.g);
+                    REVALIDATE(result.b);
+                    
+                    path += result;
+                }
+            }
+            #endif
+
+            // CAUSTIC PHOTON GATHERING
+            if (caustic == Caustic::DIFFUSE && photon_map.enabled())
             {
-                // metallic reflection
-                const auto specular = shade_ggx();
-                
-                ray.origin = nearest_intersection.position + normal * .001f;
-                // TODO: sample according to roughness and anisotropy
-                ray.direction = glm::normalize(reflection + random_in_unit_sphere * nearest_intersection.material.roughness);
-                
-                absorption = specular * albedo;
-                weight = metal_weight;
+                // caustics arriving here, which paths leaving this point no longer find themselves
+                path += albedo / glm::pi<Real>() * photon_map.estimate(nearest_intersection.position, normal) / weight;
             }
-            else if (random < metal_weight + reflection_weight)
+            
+            // IRRADIANCE CACHE PATH TERMINATION
+            if (lobe == Lobe::DIFFUSE && irradiance_cache.enabled() && !scattering.gathering && bounces > 1)
             {
-                // dielectric reflection
-                const auto specular = shade_ggx();
-                
-                ray.origin = nearest_intersection.position + normal * .001f;
-                // TODO: sample according to roughness and anisotropy
-                ray.direction = glm::normalize(reflection + random_in_unit_sphere * nearest_intersection.material.roughness);
+                // diffuse interreflection is interpolated from nearby records, or gathered into a new one where none reach
+                auto irradiance = glm::vec3{ 0.f };
+                if (!irradiance_cache.lookup(nearest_intersection.position, normal, irradiance))
+                {
+                    irradiance = compute_irradiance(nearest_intersection.position, normal, basis, bounces, scattering.depth);
+                }
 
-                absorption = specular * glm::vec3{ mat.transmission };
-                weight = reflection_weight;
+                path += albedo / glm::pi<Real>() * irradiance / weight;
             }
-            else if (random < metal_weight + reflection_weight + refraction_weight)
+            // STANDARD PATH TERMINATION
+            else if (absorption != glm::vec3{ 0.f })
             {
-                // dielectric refraction
-                const auto eta = glm::dot(normal, -ray.direction) > 0.f 
-                    ? (1.f / nearest_intersection.material.refraction_index) 
-                    : nearest_intersection.material.refraction_index;
+                const auto scattered = Scattering
+                {
+                    .position = nearest_intersection.position,
+                    .normal = normal,
+                    .pdf = scattered_pdf,
+                    .gathering = scattering.gathering,
+                    .depth = scattering.depth + 1,
+                    .caustic = caustic,
+                };
 
-                auto refraction = glm::refract(ray.direction, normal, eta);
+                // output_intersection reports the first hit of this ray only
+                auto next_intersection = RayIntersection{};
+                path += absorption * trace(ray, bounces - 1, next_intersection, sampler, scattered) / weight;
+            }
 
-                if (glm::length2(refraction) < .001f)
-                {
-                    // total internal reflection
-                    refraction = reflection;
-                    ray.origin = nearest_intersection.position + normal * .001f;
-                }
-                else
+            // what this path found is one more sample of the radiance leaving the surface here
+            if (cacheable)
+            {
+                radiance_cache.update(nearest_intersection.position, normal, path);
+            }
+
+            return path;
+        }
+        else
+        {
+            if constexpr (ENABLE_SKYBOX)
+            {
+                // next-event estimation from the previous bounce could have aimed at this same part of the sky
+                auto weight = 1.f;
+
+            #ifdef ENABLE_DLS
+                if (scattering.pdf > 0.f)
                 {
-                    // NOTE: IMPORTANT--OFFSET IS POSSIBLY A NEGATIVE MARGIN TO AVOID SELF-INTERSECTION FOR REFRACTION RAY
-                    ray.origin = nearest_intersection.position + (is_front_face ? -normal : normal) * .001f;
+                    weight = compute_power_heuristic(scattering.pdf, compute_environment_probability() * environment.pdf(ray.direction));
                 }
+            #endif
 
-                ray.direction = glm::normalize(refraction + random_in_unit_sphere * nearest_intersection.material.roughness);
+                return compute_skybox_radiance(ray.direction) * weight;
+            }
+        }
 
-                // Beer-Lambert attenuation (re-using albedo as absorption)
-                const auto attenuation_distance = nearest_intersection.exit - nearest_intersection.depth;
-                const auto attenuation = glm::exp(-mat.albedo * attenuation_distance);
+        return glm::vec3{ 0.f };
+    };
+
+    // irradiance at a diffuse point from everything but next-event estimation there, gathered over a stratified
+    // hemisphere and cached with its gradients for the points around it
+    glm::vec3 compute_irradiance(const glm::vec3& position, const glm::vec3& normal, const glm::mat3& basis, int bounces, int depth)
+    {
+        // independent numbers, so that the hundreds of gather paths leave the dimensions of the pixel's own path alone
+        auto sampler = Sampler{ SamplerType::INDEPENDENT, 0, 0, _seed };
+        auto gather = IrradianceGather{};
+
+        for (auto j = 0u; j < IrradianceGather::THETA; j++)
+        {
+            for (auto k = 0u; k < IrradianceGather::PHI; k++)
+            {
+                sampler.start(j * IrradianceGather::PHI + k);
 
-                absorption = attenuation;
-                weight = refraction_weight;
+                const auto local = IrradianceGather::direction(j, k, sampler.next_2d());
+                auto ray = Ray{ position + normal * .001f, glm::normalize(basis * local) };
+
+                // weighted against next-event estimation from this point just as a diffuse bounce from it would be
+                const auto scattered = Scattering
+                {
+                    .position = position,
+                    .normal = normal,
+                    .pdf = local.z / glm::pi<Real>(),
+                    .gathering = true,
+                    .depth = depth + 1,
+                    .caustic = Caustic::DIFFUSE,
+                };
+
+                auto intersection = RayIntersection{};
+                auto radiance = trace(ray, bounces - 1, intersection, sampler, scattered);
+                REVALIDATE(radiance.r);
+                REVALIDATE(radiance.g);
+                REVALIDATE(radiance.b);
+
+                gather.add(j, k, local, radiance, intersection.hit ? intersection.depth : std::numeric_limits<Real>::infinity());
             }
-            else
+        }
+
+        const auto record = irradiance_cache.record(position, basis, gather);
+        irradiance_cache.insert(record);
+
+        return record.irradiance;
+    }
+
+    // gathers what emits light in every instance, for next-event estimation and photon emission to pick from
+    void compute_emitters()
+    {
+        for (auto index = 0u; index < scene.instances.size(); index++)
+        {
+            const auto& instance = scene.instances[index];
+
+            for (auto object : instance.mesh)
             {
-                // diffuse scattering
+                const auto material = instance.material_of(*object);
 
-                // cosine-weighted hemisphere random sampling per lambertian BRDF
-                // heavily modified from the cosine distribution method plus re-basis using orthonormal space
-                // https://www.rorydriscoll.com/2009/01/07/better-sampling/
+                if (scene.materials[material].emission != glm::vec3{ 0.f })
+                {
+                    // sampled where the instance draws it, as the faces below are
+                    const auto world = instance.transform == glm::identity<glm::mat4>() ? object : scene.arena.make<InstancedObject>(object, instance);
+
+                    emissive_objects.emplace_back(Emitter
+                    { 
+                        .object = world, 
+                        .material = material,
+                        .power = glm::length(scene.materials[material].emission), 
+                        .key = EmitterKey{ .instance = index, .object = object },
+                    });
+                }
+            }
 
-                const auto disk = glm::diskRand(1.f);
-                const auto z = glm::sqrt(glm::clamp(1.f - disk.x * disk.x - disk.y * disk.y, 0.f, 1.f));
+            // faces loaded from a file have no authoring object to sample, so each emissive one gets a world-space
+            // triangle of its own for this instance
+            const auto& triangles = instance.mesh.store.triangles;
+            for (auto face = 0u; face < triangles.size(); face++)
+            {
+                const auto material = instance.material != NO_MATERIAL ? instance.material : triangles.face_materials[face];
 
-                const auto local_coodinates = glm::vec3{ disk.x, disk.y, z };
-            
-                auto tangent = glm::normalize(glm::cross(normal, glm::vec3{ 0.f, 0.f, 1.f }));
-                if (glm::length2(tangent) < .001f)
+                if (triangles.face_objects[face] != nullptr || scene.materials[material].emission == glm::vec3{ 0.f })
                 {
-                    tangent = glm::normalize(glm::cross(normal, glm::vec3{ 0.f, 1.f, 0.f }));
+                    continue;
                 }
 
-                const auto bitangent = glm::normalize(glm::cross(tangent, normal));
+                const auto corner = [&](std::uint32_t i)
+                {
+                    return glm::vec3{ instance.transform * glm::vec4{ triangles.position(face, i), 1.f } };
+                };
 
-                const auto basis = glm::mat3{ tangent, bitangent, normal };
-                const auto world_coordinates = basis * local_coodinates;
+                const auto v0 = corner(0), v1 = corner(1), v2 = corner(2);
+                if (glm::length2(glm::cross(v1 - v0, v2 - v0)) == 0.f)
+                {
+                    continue;
+                }
 
-                ray.origin = nearest_intersection.position + normal * .001f;
-                ray.direction = glm::normalize(world_coordinates);
+                // without UVs the barycentric coordinates stand in for them, as when the face is hit
+                const auto uv = [&](std::uint32_t i, const glm::vec2& barycentric)
+                {
+                    return triangles.uvs.empty() ? barycentric : triangles.uvs[triangles.indices[3 * face + i]];
+                };
 
-                absorption = albedo;
-                weight = diffuse_weight;
+                const auto triangle = scene.arena.make<Triangle>(v0, v1, v2,
+                    uv(0, glm::vec2{ 0.f, 0.f }), uv(1, glm::vec2{ 1.f, 0.f }), uv(2, glm::vec2{ 0.f, 1.f }), material);
+
+                emissive_objects.emplace_back(Emitter
+                {
+                    .object = triangle,
+                    .material = material,
+                    .power = glm::length(scene.materials[material].emission),
+                    .key = EmitterKey{ .instance = index, .face = face },
+                });
             }
+        }
 
-            auto path = glm::vec3{ 0.f };
+        // pre-compute the emissivity of each emitter to weight its sampling as part of importance sampling
+        auto emitters = std::vector<Object*>{};
+        auto emissivities = std::vector<Real>{};
+        emitters.reserve(emissive_objects.size());
+        emissivities.reserve(emissive_objects.size());
+        for (const auto& emitter : emissive_objects)
+        {
+            emitter_indices.try_emplace(emitter.key, static_cast<std::uint32_t>(emitters.size()));
+            emitters.push_back(emitter.object);
+            emissivities.push_back(compute_emissivity(emitter));
+        }
 
-            #define ENABLE_DLS
-            #ifdef ENABLE_DLS
+        light_sampler = LightSampler{ _lights };
+        light_sampler.build(emitters, emissivities);
 
-            // DIRECT LIGHT SAMPLING PATH TERMINATION
-            if (!emissive_objects.empty())
+        photon_emitters.build(emissivities);
+    }
+
+    // a photon from an emitter, followed through near-specular surfaces to the diffuse one it lands on. it scatters
+    // through the same lobes as a path would, and anywhere but the end of a caustic it is dropped with no power
+    Photon trace_photon(std::size_t count)
+    {
+        auto& random = rng();
+
+        const auto index = photon_emitters.sample(random.uniform());
+        const auto& emitter = emissive_objects[index];
+
+        const auto origin = emitter.object->sample(glm::vec2{ random.uniform(), random.uniform() });
+        auto normal = glm::normalize(emitter.object->normal_of(origin));
+
+        // open surfaces emit from both faces as they are seen from both, closed ones only outward
+        const auto type = emitter.object->type();
+        const auto two_sided = type == PrimitiveType::TRIANGLE || type == PrimitiveType::QUADRILATERAL;
+        if (two_sided && random.uniform() < .5f)
+        {
+            normal = -normal;
+        }
+
+        // radiance times cosine over the density of the photon, in which the cosines cancel
+        const auto area_pdf = photon_emitters.probability(index) * emitter.object->pdf(origin) * (two_sided ? .5f : 1.f);
+        auto power = scene.materials[emitter.material].emission * glm::pi<Real>() / (area_pdf * static_cast<Real>(count));
+
+        auto ray = Ray{ origin + normal * .001f, compute_basis(normal) * random.cosine_hemisphere() };
+        auto specular = false;
+
+        for (auto bounce = 0; bounce < _bounces; bounce++)
+        {
+            const auto intersection = compute_nearest_intersection(ray);
+            // media have no surface for a photon to land on
+            if (!intersection.hit || intersection.material->emission != glm::vec3{ 0.f } || compute_medium(intersection))
             {
-                auto sampled_emitter = Emitter{ nullptr, 0.f, 0.f }; 
-                const auto emitter_random = glm::linearRand(0.f, 1.f);
-                auto emitter_cdf = 0.f;
-                for (const auto& emitter : emissive_objects)
-                {
-                    emitter_cdf += emitter.probability;
-                    if (emitter_random <= emitter_cdf)
-                    {
-                        sampled_emitter = emitter;
-                        break;
-                    }
-                }
+                break;
+            }
 
-                if (sampled_emitter.object)
-                {
-                    // direct light importance sampling https://raytracing.github.io/books/RayTracingTheRestOfYourLife.html#samplinglightsdirectly/
-                    const auto light_sample = sampled_emitter.object->sample();
-                    const auto light_normal = sampled_emitter.object->normal_of(light_sample);
+            auto albedo = intersection.material->albedo;
 
-                    auto light_direction = light_sample - ray.origin;
-                    auto distance2 = glm::length2(light_direction);
-                    light_direction = glm::normalize(light_direction);
+            if (intersection.material->texture)
+            {
+                const auto& uv = intersection.uv;
+                const auto sample = intersection.material->texture->Sample(uv.x, uv.y, intersection.position);
+                albedo = glm::vec3{ sample.r / 255.f, sample.g / 255.f, sample.b / 255.f };
+            }
 
-                    const auto normal_cosine = glm::clamp(glm::dot(normal, light_direction), 0.f, 1.f);
+            albedo *= intersection.attenuation;
 
-                    const auto light_area = sampled_emitter.object->area;
-                    const auto light_cosine = glm::clamp(glm::dot(light_normal, light_direction), 0.f, 1.f);
+            auto surface_normal = intersection.normal;
+            const bool is_front_face = glm::dot(surface_normal, ray.direction) < 0.f;
+            surface_normal = is_front_face ? surface_normal : -surface_normal;
 
-                    // next-event estimation direct light sampling per bounce
-                    // https://www.cg.tuwien.ac.at/sites/default/files/course/4411/attachments/08_next%20event%20estimation.pdf
-                    auto light_ray = Ray
-                    {
-                        .origin = ray.origin + normal * .001f,
-                        .direction = light_direction,
-                    };
+            const auto& mat = *intersection.material;
 
-                    const auto geometry = (normal_cosine * light_cosine) / distance2;
-                    const auto radiance = sampled_emitter.object->material.emission;
+            // lobes are weighted exactly as trace() weights them, which the caustic estimate relies on
+            const auto normal_angle = glm::clamp(glm::dot(surface_normal, ray.direction), 0.f, 1.f);
+            const auto F0 = glm::mix(glm::vec3{ NONMETAL_REFLECTANCE }, albedo, mat.metallicity);
+            const auto F = compute_fresnel_F(F0, 1.f - normal_angle);
 
-                    const auto pdf = distance2 / (light_cosine * light_area);
+            const auto weights = compute_lobe_weights(mat, F);
+            const auto lobe = weights.choose(random.uniform());
 
-                    const auto occlusion = compute_nearest_intersection(light_ray);
-                    if (occlusion.hit && occlusion.object == sampled_emitter.object)
-                    {
-                        auto result = absorption * radiance * geometry / (weight * pdf);
-                        REVALIDATE(result.r);
-                        REVALIDATE(result.g);
-                        REVALIDATE(result.b);
-                        
-                        path += result;
-                    }
+            if (lobe == Lobe::DIFFUSE)
+            {
+                // kept only where a diffuse path would gather it, so in proportion to the diffuse lobe's share
+                if (specular)
+                {
+                    return Photon{ intersection.position, surface_normal, power / weights.diffuse };
                 }
+
+                break;
             }
-            #endif
-            
-            // STANDARD PATH TERMINATION
+
+            // glossy reflection spreads light too widely to focus a caustic, and paths find that light well themselves
+            if (!compute_specular(lobe, mat))
             {
-                path += absorption * trace(ray, bounces - 1, output_intersection) / weight;
+                break;
             }
 
-            return path;
-        }
-        else
-        {
-            if constexpr (ENABLE_SKYBOX)
+            auto pdf = 0.f;
+            const auto absorption = compute_scattering(ray, intersection, surface_normal, is_front_face, lobe, compute_basis(surface_normal), compute_alpha(mat), F0, albedo, glm::vec2{ random.uniform(), random.uniform() }, pdf);
+
+            power *= absorption / weights.of(lobe);
+            specular = true;
+
+            if (power == glm::vec3{ 0.f })
             {
-                const auto uv = compute_skybox_uv_coordinates(ray.direction);
-                const auto sample = skybox->Sample(uv.x, uv.y);
-                return glm::vec3{ sample.r / 255.f, sample.g / 255.f, sample.b / 255.f };
+                break;
             }
         }
 
-        return glm::vec3{ 0.f };
-    };
+        return Photon{};
+    }
+
+    // one pass of caustic photons, traced in parallel and then sorted into the photon map
+    void compute_photons()
+    {
+        const auto count = photon_map.photons_per_pass();
+        auto photons = std::vector<Photon>(emissive_objects.empty() ? 0 : count);
+
+        std::for_each(std::execution::par, photons.begin(), photons.end(), [&](Photon& photon)
+        {
+            const auto index = static_cast<std::uint64_t>(&photon - photons.data());
+
+            // streams past those of the pixels, so photons and paths never draw the same numbers
+            seed_pixel(_seed, frame_index, index_buffer.size() + index);
+            photon = trace_photon(count);
+        });
+
+        std::erase_if(photons, [](const Photon& photon)
+        {
+            return !(glm::compMax(photon.power) > 0.f) || glm::any(glm::isinf(photon.power));
+        });
+
+        photon_map.build(std::move(photons));
+    }
 
     Real compute_focal_length(Real fov)
     {
@@ -592,20 +1272,26 @@ public:
         index_buffer.resize(number, 0);
         std::iota(index_buffer.begin(), index_buffer.end(), 0);
 
+        sample_allocator = SampleAllocator{ _noise, static_cast<std::uint32_t>(_samples) };
+        sample_allocator.resize(number);
+
+        irradiance_cache.reset(position, compute_pixel_angle());
+        photon_map.reset(position, compute_pixel_angle());
+
         initialize_textures();
 
     #ifndef CORNELL
-        scene_instances.emplace_back(test_spheres());
+        scene.instances.emplace_back(test_spheres(scene));
     #else
-        scene_instances.emplace_back(cornell_box());
+        scene.instances.emplace_back(cornell_box(scene));
 
-        static const auto sphere = Mesh
+        const auto& sphere = *scene.arena.make<Mesh>(std::vector<Object*>
         {
-            new Sphere
-            { 
+            scene.arena.make<Sphere>
+            ( 
                 glm::vec3{ .5f, .6f, .5f }, 
                 .4f, 
-                PBRMaterial
+                scene.materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .2f, .4f, .9f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -614,13 +1300,13 @@ public:
                     .anisotropy = 0.f,
                     .roughness = 0.f,
                     .transmission = .02f,
-                }
-            }
-        };
+                })
+            )
+        });
 
-        scene_instances.emplace_back(MeshInstance{ glm::identity<glm::mat4>(), sphere });
+        scene.instances.emplace_back(MeshInstance{ glm::identity<glm::mat4>(), sphere });
 
-        static const auto prism = cube(PBRMaterial
+        const auto& prism = *scene.arena.make<Mesh>(cube(scene.materials.add(PBRMaterial
         {
             .albedo = glm::vec3{ .9f, .9f, .1f },
             .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -629,38 +1315,24 @@ public:
             .anisotropy = 0.f,
             .roughness = .01f,
             .transmission = .97f,
-        });
-        static const auto prism_instance = MeshInstance
+        })));
+        const auto prism_instance = MeshInstance
         {
             glm::rotate(glm::translate(glm::scale(glm::identity<glm::mat4>(), glm::vec3{ .2f }), glm::vec3{ -1.5f, -2.f, .5f }), glm::radians(45.f), UP),
             prism
         };
 
-        scene_instances.emplace_back(prism_instance);
+        scene.instances.emplace_back(prism_instance);
 
     #endif
 
-        for (auto& instance : scene_instances)
-        {
-            for (auto object : instance.mesh)
-            {
-                if (object && object->material.emission != glm::vec3{ 0.f })
-                {
-                    emissive_objects.emplace_back(Emitter
-                    { 
-                        .object = object, 
-                        .power = glm::length(object->material.emission), 
-                        .probability = 0.f,
-                    });
-                }
-            }
-        }
+        scene.build();
+
+        compute_emitters();
 
-        for (auto& emitter : emissive_objects)
+        if constexpr (ENABLE_SKYBOX)
         {
-            // pre-compute the probability of sampling each emitter weighted by emissivity as part of importance sampling
-            emitter.probability = compute_emissivity(emitter) / std::accumulate(emissive_objects.begin(), emissive_objects.end(), 0.f, 
-                [&](auto sum, auto emitter) { return sum + compute_emissivity(emitter); });
+            environment.build(*skybox);
         }
 
 		return true;
@@ -680,6 +1352,26 @@ public:
             const auto fnumber = compute_fnumber(focal_length, aperture_radius);
             DrawStringPropDecal({ 5.f, 55.f }, std::format("Focal Length: {:.2f}mm ({:.0f}deg)", focal_length, fov_degrees), olc::YELLOW);
             DrawStringPropDecal({ 5.f, 65.f }, std::format("Aperture: f/{:.2f} (r={:.2f}mm)", fnumber, aperture_radius), olc::YELLOW);
+
+            if (sample_allocator.adaptive())
+            {
+                DrawStringPropDecal({ 5.f, 75.f }, std::format("Adaptive: {:.1f}% converged", sample_allocator.converged() * 100.f), olc::YELLOW);
+            }
+
+            if (irradiance_cache.enabled())
+            {
+                DrawStringPropDecal({ 5.f, 85.f }, std::format("Irradiance Cache: {} records", irradiance_cache.size()), olc::YELLOW);
+            }
+
+            if (radiance_cache.enabled())
+            {
+                DrawStringPropDecal({ 5.f, 95.f }, std::format("Radiance Cache: {} ({} cells)", enable_radiance_cache ? "ON" : "OFF", radiance_cache.size()), olc::YELLOW);
+            }
+
+            if (photon_map.enabled())
+            {
+                DrawStringPropDecal({ 5.f, 105.f }, std::format("Photon Map: {} caustic photons (r={:.4f})", photon_map.size(), photon_map.gather_radius()), olc::YELLOW);
+            }
         }
 
         if (GetKey(olc::Key::P).bPressed)
@@ -693,6 +1385,18 @@ public:
             enable_ui = !enable_ui;
         }
 
+        if (GetKey(olc::Key::V).bPressed)
+        {
+            enable_sample_view = !enable_sample_view;
+        }
+
+        // flips between ending paths in the radiance cache and the unbiased image, for comparing the two
+        if (GetKey(olc::Key::R).bPressed && radiance_cache.enabled())
+        {
+            enable_radiance_cache = !enable_radiance_cache;
+            dirty = true;
+        }
+
         if (GetMouse(olc::Mouse::LEFT).bHeld || GetMouse(olc::Mouse::RIGHT).bHeld)
         {
             const auto delta = GetMousePos() - last_mouse_position;
@@ -733,7 +1437,7 @@ public:
         if (wheel != 0)
         {
             focal_distance += static_cast<Real>(wheel) * fElapsedTime;
-            // small epsilon required--0.f crashes the program from diskRand()!
+            // small epsilon required--0.f crashes the program!
             focal_distance = glm::max(focal_distance, .001f);
             dirty = true;
         }
@@ -826,38 +1530,79 @@ public:
             return gamma_corrected;
         };
 
+        const auto right = compute_right();
+        const auto exposure = ISO / BASE_ISO;
+
+        // the camera moved last frame, so every estimate so far belongs to the old view
+        if (last_dirty)
+        {
+            sample_allocator.reset();
+            // records are sized by their footprint on screen, so they go with the view that they were gathered for
+            irradiance_cache.reset(position, compute_pixel_angle());
+            // as are the passes of the photon map, whose first radius is sized on screen too
+            photon_map.reset(position, compute_pixel_angle());
+        }
+
+        sample_allocator.allocate(exposure);
+
+        if (radiance_cache.enabled())
+        {
+            radiance_cache.resolve(position, compute_pixel_angle());
+        }
+
+        if (photon_map.enabled())
+        {
+            compute_photons();
+        }
+
         std::for_each(std::execution::par, index_buffer.begin(), index_buffer.end(), [&](int i)
         {
             const auto x = i % ScreenWidth();
             const auto y = i / ScreenWidth();
 
+            // the pixel's sequence depends only on the seed, frame and pixel, never on the worker thread
+            seed_pixel(_seed, frame_index, i);
+
             const auto& ray = rays[i];
 
             auto total_color = glm::vec3{ 0.f, 0.f, 0.f };
 
-            for (int s = 0; s < _samples; s++)
+            auto sampler = Sampler{ _sampler, static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), _seed };
+
+            auto& statistics = sample_allocator[i];
+            const auto samples = sample_allocator.samples_of(i);
+
+            for (auto s = 0u; s < samples; s++)
             {
+                // sample indices keep counting across frames so that accumulated frames continue one sequence
+                sampler.start(statistics.sequence);
+
                 // using linear to avoid biasing sampling toward the center of each pixel
+                const auto jitter = (2.f * sampler.next_2d() - 1.f) * SAMPLE_JITTER;
                 auto ray_jittered = ray;
-                ray_jittered.direction += glm::linearRand(glm::vec3{ -SAMPLE_JITTER, -SAMPLE_JITTER, -SAMPLE_JITTER }, glm::vec3{ SAMPLE_JITTER, SAMPLE_JITTER, SAMPLE_JITTER });
+                ray_jittered.direction += right * jitter.x + UP * jitter.y;
                 ray_jittered.direction = glm::normalize(ray_jittered.direction);
 
+                // drawn even without depth of field so that the tracing dimensions do not move when it is toggled
+                const auto lens_sample = sampler.next_2d();
+
                 if (enable_dof)
                 {
-                    const auto disk_sample = glm::diskRand(aperture_radius);
+                    const auto disk_sample = sample_disk(lens_sample, aperture_radius);
                     // effectively runs the UV coordinate-back calculation like in https://raytracing.github.io/books/RayTracingInOneWeekend.html#dielectrics/refraction
-                    ray_jittered.origin += compute_right() * disk_sample.x + UP * disk_sample.y;
+                    ray_jittered.origin += right * disk_sample.x + UP * disk_sample.y;
                     // TODO: ask Schaeffer about this step. It works correctly per Ray Tracing in One Weekend, but not sure why.
                     const auto focal_point = ray.origin + ray.direction * focal_distance;
                     ray_jittered.direction = glm::normalize(focal_point - ray_jittered.origin);
                 }
 
                 auto intersection = RayIntersection{};
-                auto result = trace(ray_jittered, _bounces, intersection);
+                auto result = trace(ray_jittered, _bounces, intersection, sampler);
                 REVALIDATE(result.r);
                 REVALIDATE(result.g);
                 REVALIDATE(result.b);
                 total_color += result;
+                statistics.add(result);
             }
 
             if (glm::any(glm::isinf(total_color)) || glm::any(glm::isnan(total_color))) 
@@ -865,14 +1610,14 @@ public:
                 total_color = glm::vec3{ 0.f };
             } 
 
-            total_color /= static_cast<Real>(_samples);
-
+            // pixels no longer take the same number of samples every frame, so each shows the tone-mapped mean of all
+            // its samples rather than the mean of its tone-mapped frames
             // IMPORTANT: MUST APPLY ISO EXPOSURE CORRECTION BEFORE AVERAGING!!!!! OTHERWISE IT'S ALMOST GRAY
-            const auto iso_corrected = total_color * (ISO / BASE_ISO);
-            const auto tonemapped = tonemap(iso_corrected);
+            const auto tonemapped = tonemap(statistics.mean * exposure);
 
-            staging_buffer[i] = tonemapped;
-            frame_buffer[i] += tonemapped;
+            // converged pixels took no samples this frame, so the motion preview falls back on their estimate
+            staging_buffer[i] = samples > 0 ? tonemap(total_color / static_cast<Real>(samples) * exposure) : tonemapped;
+            frame_buffer[i] = tonemapped;
         });
 
         if (!dirty && last_dirty)
@@ -895,8 +1640,6 @@ public:
             const auto aspect_ratio = static_cast<Real>(ScreenWidth()) / static_cast<Real>(ScreenHeight());
             const auto fov_radians = glm::radians(fov_degrees);
 
-            const auto right = compute_right();
-
             const auto projection = glm::perspective(fov_radians, aspect_ratio, .1f, 1000.f);
             const auto inverse_projection = glm::inverse(projection);
             const auto view = glm::lookAt(position, position + compute_direction(), UP);
@@ -937,7 +1680,22 @@ public:
             {
                 for (int y = 0; y < ScreenHeight(); y++)
                 {
-                    const auto color = frame_buffer[x + y * ScreenWidth()] / static_cast<Real>(accumulated_frames);
+                    const auto color = frame_buffer[x + y * ScreenWidth()];
+                    Draw(x, y, olc::Pixel(color.r * 255.f, color.g * 255.f, color.b * 255.f));
+                }
+            }
+        }
+
+        if (enable_sample_view)
+        {
+            for (int x = 0; x < ScreenWidth(); x++)
+            {
+                for (int y = 0; y < ScreenHeight(); y++)
+                {
+                    // black for converged pixels, then blue through red up to the most any pixel may take
+                    const auto samples = sample_allocator.samples_of(x + y * ScreenWidth());
+                    const auto t = static_cast<Real>(samples) / static_cast<Real>(sample_allocator.maximum());
+                    const auto color = samples > 0 ? glm::mix(glm::vec3{ 0.f, 0.f, 1.f }, glm::vec3{ 1.f, 0.f, 0.f }, glm::sqrt(t)) : glm::vec3{ 0.f };
                     Draw(x, y, olc::Pixel(color.r * 255.f, color.g * 255.f, color.b * 255.f));
                 }
             }
@@ -949,6 +1707,7 @@ public:
         last_dirty = dirty;
         dirty = false;
         accumulated_frames++;
+        frame_index++;
 
 		return true;
 	}
@@ -976,6 +1735,19 @@ ParseResult parse_int(const std::string& input)
 	return { success, result };
 }
 
+struct ParseRealResult
+{
+	bool success;
+	Real result;
+};
+ParseRealResult parse_real(const std::string& input)
+{
+	char* end = nullptr;
+	const auto result = std::strtof(input.c_str(), &end);
+	bool success = !input.empty() && end == input.c_str() + input.size();
+	return { success, result };
+}
+
 int main(int argc, char** argv)
 {
     int width = 500, height = 500;
@@ -1020,6 +1792,38 @@ int main(int argc, char** argv)
                     _samples = result.result;
                 }
             }
+            else if (name == "-noise")
+            {
+                const auto result = parse_real(value);
+                if (result.success && result.result >= 0.f)
+                {
+                    _noise = result.result;
+                }
+            }
+            else if (name == "-irradiance")
+            {
+                const auto result = parse_real(value);
+                if (result.success && result.result >= 0.f)
+                {
+                    _irradiance = result.result;
+                }
+            }
+            else if (name == "-radiance")
+            {
+                const auto result = parse_int(value);
+                if (result.success && result.result >= 0)
+                {
+                    _radiance = result.result;
+                }
+            }
+            else if (name == "-photons")
+            {
+                const auto result = parse_int(value);
+                if (result.success && result.result >= 0)
+                {
+                    _photons = result.result;
+                }
+            }
             else if (name == "-captures")
             {
                 const auto result = parse_int(value);
@@ -1028,6 +1832,44 @@ int main(int argc, char** argv)
                     _captures = result.result;
                 }
             }
+            else if (name == "-sampler")
+            {
+                if (value == "independent")
+                {
+                    _sampler = SamplerType::INDEPENDENT;
+                }
+                else if (value == "halton")
+                {
+                    _sampler = SamplerType::HALTON;
+                }
+                else if (value == "sobol")
+                {
+                    _sampler = SamplerType::SOBOL;
+                }
+                else if (value == "bluenoise")
+                {
+                    _sampler = SamplerType::BLUE_NOISE;
+                }
+            }
+            else if (name == "-lights")
+            {
+                if (value == "power")
+                {
+                    _lights = LightSamplerType::POWER;
+                }
+                else if (value == "hierarchy")
+                {
+                    _lights = LightSamplerType::HIERARCHY;
+                }
+            }
+            else if (name == "-seed")
+            {
+                const auto result = parse_int(value);
+                if (result.success)
+                {
+                    _seed = static_cast<std::uint64_t>(result.result);
+                }
+            }
         }
     }
 
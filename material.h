@@ -1,12 +1,57 @@
 #ifndef IRRADIANCE_MATERIAL_H
 #define IRRADIANCE_MATERIAL_H
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "utility.h"
+
 // material.h
 // (c) 2025 Connor J. Link. All Rights Reserved.
 
 namespace ir
 {
+    using MaterialId = std::uint32_t;
+
+    static constexpr MaterialId NO_MATERIAL = std::numeric_limits<MaterialId>::max();
+
+    // every material of a scene, with primitives and instances referring to entries by id. equal materials added
+    // separately get entries of their own, so that editing one never changes another.
+    // NOTE: entries are only added while the scene is being set up; hits point directly into the table during rendering
+    class MaterialTable
+    {
+    private:
+        std::vector<PBRMaterial> materials;
+
+    public:
+        MaterialId add(const PBRMaterial& material)
+        {
+            materials.push_back(material);
+            return static_cast<MaterialId>(materials.size() - 1);
+        }
+
+        void clear()
+        {
+            materials.clear();
+        }
+
+    public:
+        PBRMaterial& operator[](MaterialId id)
+        {
+            return materials[id];
+        }
+
+        const PBRMaterial& operator[](MaterialId id) const
+        {
+            return materials[id];
+        }
 
+        std::size_t size() const
+        {
+            return materials.size();
+        }
+    };
 }
 
-#endif 
+#endif
@@ -5,32 +5,32 @@
 
 namespace ir
 {
-    Mesh icosphere(const PBRMaterial& material)
+    Mesh icosphere(MaterialId material)
     {
         return load_obj("icosphere.obj", material);
     }
 
-    Mesh torus(const PBRMaterial& material)
+    Mesh torus(MaterialId material)
     {
         return load_obj("torus.obj", material);
     }
 
-    Mesh cube(const PBRMaterial& material)
+    Mesh cube(MaterialId material)
     {
         return load_obj("cube.obj", material);
     }
 
-    Mesh cylinder(const PBRMaterial& material)
+    Mesh cylinder(MaterialId material)
     {
         return load_obj("cylinder.obj", material);
     }
 
-    Mesh teapot(const PBRMaterial& material)
+    Mesh teapot(MaterialId material)
     {
         return load_obj("teapot.obj", material);
     }
 
-    Mesh monkey(const PBRMaterial& material)
+    Mesh monkey(MaterialId material)
     {
         return load_obj("monkey.obj", material);
     }
@@ -12,12 +12,12 @@
 
 namespace ir
 {
-    Mesh icosphere(const PBRMaterial& material = PBRMaterial{});
-    Mesh torus(const PBRMaterial& material = PBRMaterial{});
-    Mesh cube(const PBRMaterial& material = PBRMaterial{});
-    Mesh cylinder(const PBRMaterial& material = PBRMaterial{});
-    Mesh teapot(const PBRMaterial& material = PBRMaterial{});
-    Mesh monkey(const PBRMaterial& material = PBRMaterial{});
+    Mesh icosphere(MaterialId material);
+    Mesh torus(MaterialId material);
+    Mesh cube(MaterialId material);
+    Mesh cylinder(MaterialId material);
+    Mesh teapot(MaterialId material);
+    Mesh monkey(MaterialId material);
 }
 
 #endif 
@@ -0,0 +1,206 @@
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <immintrin.h>
+    #define IRRADIANCE_PACKET_SSE
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define IRRADIANCE_PACKET_NEON
+#endif
+
+#include "packet.h"
+
+// packet.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // same thresholds as the scalar triangle test in primitives.cpp
+    static constexpr ir::Real PARALLEL_EPSILON = .001f;
+    static constexpr ir::Real DEPTH_EPSILON = .001f;
+
+    bool select_nearest(const ir::TrianglePacket& packet, const float* depths, const float* us, const float* vs, ir::PacketHit& hit)
+    {
+        auto lane = ir::TrianglePacket::WIDTH;
+        auto nearest = std::numeric_limits<ir::Real>::infinity();
+
+        for (auto i = 0uz; i < ir::TrianglePacket::WIDTH; i++)
+        {
+            if (depths[i] < nearest)
+            {
+                nearest = depths[i];
+                lane = i;
+            }
+        }
+
+        if (lane == ir::TrianglePacket::WIDTH)
+        {
+            return false;
+        }
+
+        hit = ir::PacketHit
+        {
+            .depth = depths[lane],
+            .barycentric = { us[lane], vs[lane] },
+            .primitive = packet.primitives[lane],
+        };
+
+        return true;
+    }
+}
+
+namespace ir
+{
+#if defined(IRRADIANCE_PACKET_SSE)
+
+    bool intersect(const TrianglePacket& packet, const Ray& ray, Real t_max, PacketHit& hit)
+    {
+        const auto ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+        const auto dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y), dz = _mm_set1_ps(ray.direction.z);
+
+        const auto e0x = _mm_load_ps(packet.e0x.data()), e0y = _mm_load_ps(packet.e0y.data()), e0z = _mm_load_ps(packet.e0z.data());
+        const auto e1x = _mm_load_ps(packet.e1x.data()), e1y = _mm_load_ps(packet.e1y.data()), e1z = _mm_load_ps(packet.e1z.data());
+
+        // test = cross(direction, edge1)
+        const auto tx = _mm_sub_ps(_mm_mul_ps(dy, e1z), _mm_mul_ps(dz, e1y));
+        const auto ty = _mm_sub_ps(_mm_mul_ps(dz, e1x), _mm_mul_ps(dx, e1z));
+        const auto tz = _mm_sub_ps(_mm_mul_ps(dx, e1y), _mm_mul_ps(dy, e1x));
+
+        const auto determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e0x, tx), _mm_mul_ps(e0y, ty)), _mm_mul_ps(e0z, tz));
+        const auto inverse_determinant = _mm_div_ps(_mm_set1_ps(1.f), determinant);
+
+        // difference = origin - v0
+        const auto sx = _mm_sub_ps(ox, _mm_load_ps(packet.v0x.data()));
+        const auto sy = _mm_sub_ps(oy, _mm_load_ps(packet.v0y.data()));
+        const auto sz = _mm_sub_ps(oz, _mm_load_ps(packet.v0z.data()));
+
+        const auto u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, tx), _mm_mul_ps(sy, ty)), _mm_mul_ps(sz, tz)), inverse_determinant);
+
+        // q = cross(difference, edge0)
+        const auto qx = _mm_sub_ps(_mm_mul_ps(sy, e0z), _mm_mul_ps(sz, e0y));
+        const auto qy = _mm_sub_ps(_mm_mul_ps(sz, e0x), _mm_mul_ps(sx, e0z));
+        const auto qz = _mm_sub_ps(_mm_mul_ps(sx, e0y), _mm_mul_ps(sy, e0x));
+
+        const auto v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverse_determinant);
+        const auto t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, qx), _mm_mul_ps(e1y, qy)), _mm_mul_ps(e1z, qz)), inverse_determinant);
+
+        const auto zero = _mm_setzero_ps();
+        const auto one = _mm_set1_ps(1.f);
+        const auto magnitude = _mm_andnot_ps(_mm_set1_ps(-0.f), determinant);
+
+        auto mask = _mm_cmpge_ps(magnitude, _mm_set1_ps(PARALLEL_EPSILON));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(u, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(u, one));
+        mask = _mm_and_ps(mask, _mm_cmpge_ps(v, zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_add_ps(u, v), one));
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(t, _mm_set1_ps(DEPTH_EPSILON)));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(t, _mm_set1_ps(t_max)));
+
+        if (_mm_movemask_ps(mask) == 0)
+        {
+            return false;
+        }
+
+        // missed lanes become infinitely far away so the scalar reduction can ignore them
+        const auto depths = _mm_or_ps(_mm_and_ps(mask, t), _mm_andnot_ps(mask, _mm_set1_ps(std::numeric_limits<Real>::infinity())));
+
+        alignas(16) float depth_lanes[TrianglePacket::WIDTH], u_lanes[TrianglePacket::WIDTH], v_lanes[TrianglePacket::WIDTH];
+        _mm_store_ps(depth_lanes, depths);
+        _mm_store_ps(u_lanes, u);
+        _mm_store_ps(v_lanes, v);
+
+        return select_nearest(packet, depth_lanes, u_lanes, v_lanes, hit);
+    }
+
+#elif defined(IRRADIANCE_PACKET_NEON)
+
+    bool intersect(const TrianglePacket& packet, const Ray& ray, Real t_max, PacketHit& hit)
+    {
+        const auto ox = vdupq_n_f32(ray.origin.x), oy = vdupq_n_f32(ray.origin.y), oz = vdupq_n_f32(ray.origin.z);
+        const auto dx = vdupq_n_f32(ray.direction.x), dy = vdupq_n_f32(ray.direction.y), dz = vdupq_n_f32(ray.direction.z);
+
+        const auto e0x = vld1q_f32(packet.e0x.data()), e0y = vld1q_f32(packet.e0y.data()), e0z = vld1q_f32(packet.e0z.data());
+        const auto e1x = vld1q_f32(packet.e1x.data()), e1y = vld1q_f32(packet.e1y.data()), e1z = vld1q_f32(packet.e1z.data());
+
+        // test = cross(direction, edge1)
+        const auto tx = vsubq_f32(vmulq_f32(dy, e1z), vmulq_f32(dz, e1y));
+        const auto ty = vsubq_f32(vmulq_f32(dz, e1x), vmulq_f32(dx, e1z));
+        const auto tz = vsubq_f32(vmulq_f32(dx, e1y), vmulq_f32(dy, e1x));
+
+        const auto determinant = vaddq_f32(vaddq_f32(vmulq_f32(e0x, tx), vmulq_f32(e0y, ty)), vmulq_f32(e0z, tz));
+        const auto inverse_determinant = vdivq_f32(vdupq_n_f32(1.f), determinant);
+
+        // difference = origin - v0
+        const auto sx = vsubq_f32(ox, vld1q_f32(packet.v0x.data()));
+        const auto sy = vsubq_f32(oy, vld1q_f32(packet.v0y.data()));
+        const auto sz = vsubq_f32(oz, vld1q_f32(packet.v0z.data()));
+
+        const auto u = vmulq_f32(vaddq_f32(vaddq_f32(vmulq_f32(sx, tx), vmulq_f32(sy, ty)), vmulq_f32(sz, tz)), inverse_determinant);
+
+        // q = cross(difference, edge0)
+        const auto qx = vsubq_f32(vmulq_f32(sy, e0z), vmulq_f32(sz, e0y));
+        const auto qy = vsubq_f32(vmulq_f32(sz, e0x), vmulq_f32(sx, e0z));
+        const auto qz = vsubq_f32(vmulq_f32(sx, e0y), vmulq_f32(sy, e0x));
+
+        const auto v = vmulq_f32(vaddq_f32(vaddq_f32(vmulq_f32(dx, qx), vmulq_f32(dy, qy)), vmulq_f32(dz, qz)), inverse_determinant);
+        const auto t = vmulq_f32(vaddq_f32(vaddq_f32(vmulq_f32(e1x, qx), vmulq_f32(e1y, qy)), vmulq_f32(e1z, qz)), inverse_determinant);
+
+        const auto zero = vdupq_n_f32(0.f);
+        const auto one = vdupq_n_f32(1.f);
+
+        auto mask = vcgeq_f32(vabsq_f32(determinant), vdupq_n_f32(PARALLEL_EPSILON));
+        mask = vandq_u32(mask, vcgeq_f32(u, zero));
+        mask = vandq_u32(mask, vcleq_f32(u, one));
+        mask = vandq_u32(mask, vcgeq_f32(v, zero));
+        mask = vandq_u32(mask, vcleq_f32(vaddq_f32(u, v), one));
+        mask = vandq_u32(mask, vcgtq_f32(t, vdupq_n_f32(DEPTH_EPSILON)));
+        mask = vandq_u32(mask, vcltq_f32(t, vdupq_n_f32(t_max)));
+
+        if (vmaxvq_u32(mask) == 0)
+        {
+            return false;
+        }
+
+        // missed lanes become infinitely far away so the scalar reduction can ignore them
+        const auto depths = vbslq_f32(mask, t, vdupq_n_f32(std::numeric_limits<Real>::infinity()));
+
+        float depth_lanes[TrianglePacket::WIDTH], u_lanes[TrianglePacket::WIDTH], v_lanes[TrianglePacket::WIDTH];
+        vst1q_f32(depth_lanes, depths);
+        vst1q_f32(u_lanes, u);
+        vst1q_f32(v_lanes, v);
+
+        return select_nearest(packet, depth_lanes, u_lanes, v_lanes, hit);
+    }
+
+#else
+
+    bool intersect(const TrianglePacket& packet, const Ray& ray, Real t_max, PacketHit& hit)
+    {
+        float depth_lanes[TrianglePacket::WIDTH], u_lanes[TrianglePacket::WIDTH], v_lanes[TrianglePacket::WIDTH];
+
+        for (auto i = 0uz; i < TrianglePacket::WIDTH; i++)
+        {
+            const auto edge0 = glm::vec3{ packet.e0x[i], packet.e0y[i], packet.e0z[i] };
+            const auto edge1 = glm::vec3{ packet.e1x[i], packet.e1y[i], packet.e1z[i] };
+
+            const auto test = glm::cross(ray.direction, edge1);
+            const auto determinant = glm::dot(edge0, test);
+            const auto inverse_determinant = 1.f / determinant;
+
+            const auto difference = ray.origin - glm::vec3{ packet.v0x[i], packet.v0y[i], packet.v0z[i] };
+            const auto q = glm::cross(difference, edge0);
+
+            const auto u = glm::dot(difference, test) * inverse_determinant;
+            const auto v = glm::dot(ray.direction, q) * inverse_determinant;
+            const auto t = glm::dot(edge1, q) * inverse_determinant;
+
+            const auto inside = glm::abs(determinant) >= PARALLEL_EPSILON && u >= 0.f && u <= 1.f && v >= 0.f && u + v <= 1.f && t > DEPTH_EPSILON && t < t_max;
+
+            depth_lanes[i] = inside ? t : std::numeric_limits<Real>::infinity();
+            u_lanes[i] = u;
+            v_lanes[i] = v;
+        }
+
+        return select_nearest(packet, depth_lanes, u_lanes, v_lanes, hit);
+    }
+
+#endif
+}
@@ -0,0 +1,74 @@
+#ifndef IRRADIANCE_PACKET_H
+#define IRRADIANCE_PACKET_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// packet.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // up to four triangles stored as structure-of-arrays lanes so that one SIMD pass tests all of them.
+    // four lanes match both SSE and NEON registers as well as the largest hierarchy leaf
+    struct alignas(16) TrianglePacket
+    {
+    public:
+        static constexpr std::size_t WIDTH = 4;
+        static constexpr std::uint32_t PADDING = std::numeric_limits<std::uint32_t>::max();
+
+    public:
+        std::array<Real, WIDTH> v0x, v0y, v0z;
+        std::array<Real, WIDTH> e0x, e0y, e0z;
+        std::array<Real, WIDTH> e1x, e1y, e1z;
+        // face index per lane, PADDING for empty lanes
+        std::array<std::uint32_t, WIDTH> primitives;
+
+    public:
+        TrianglePacket()
+        {
+            // zero edges give a zero determinant, so padded lanes can never report a hit
+            v0x.fill(0.f); v0y.fill(0.f); v0z.fill(0.f);
+            e0x.fill(0.f); e0y.fill(0.f); e0z.fill(0.f);
+            e1x.fill(0.f); e1y.fill(0.f); e1z.fill(0.f);
+            primitives.fill(PADDING);
+        }
+
+    public:
+        void set(std::size_t lane, const glm::vec3& v0, const glm::vec3& edge0, const glm::vec3& edge1, std::uint32_t primitive)
+        {
+            v0x[lane] = v0.x; v0y[lane] = v0.y; v0z[lane] = v0.z;
+            e0x[lane] = edge0.x; e0y[lane] = edge0.y; e0z[lane] = edge0.z;
+            e1x[lane] = edge1.x; e1y[lane] = edge1.y; e1z[lane] = edge1.z;
+            primitives[lane] = primitive;
+        }
+
+        std::uint32_t size() const
+        {
+            auto count = 0u;
+            for (const auto primitive : primitives)
+            {
+                count += (primitive != PADDING);
+            }
+            return count;
+        }
+    };
+
+    struct PacketHit
+    {
+        Real depth;
+        glm::vec2 barycentric;
+        std::uint32_t primitive;
+    };
+
+    // Möller-Trumbore across every lane at once, matching the scalar triangle test lane for lane.
+    // returns true and fills hit with the nearest lane if any lane is hit in front of t_max
+    bool intersect(const TrianglePacket& packet, const Ray& ray, Real t_max, PacketHit& hit);
+}
+
+#endif
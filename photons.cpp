@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <execution>
+
+#include "glm/gtc/constants.hpp"
+
+#include "photons.h"
+
+// photons.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    glm::ivec3 PhotonMap::cell_of(const glm::vec3& position) const
+    {
+        // cells twice the radius wide, so that the radius about any point overlaps at most two per axis
+        return glm::ivec3{ glm::floor(position / (2.f * radius)) };
+    }
+
+    std::uint32_t PhotonMap::slot_of(const glm::ivec3& cell) const
+    {
+        // https://matthias-research.github.io/pages/publications/tetraederCollision.pdf
+        const auto x = static_cast<std::uint32_t>(cell.x) * 73856093u;
+        const auto y = static_cast<std::uint32_t>(cell.y) * 19349663u;
+        const auto z = static_cast<std::uint32_t>(cell.z) * 83492791u;
+
+        return (x ^ y ^ z) & static_cast<std::uint32_t>(slots.size() - 1);
+    }
+
+    void PhotonMap::reset(const glm::vec3& camera, Real pixel_angle)
+    {
+        this->camera = camera;
+        this->pixel_angle = pixel_angle;
+
+        radius = 0.f;
+        passes = 0;
+
+        photons.clear();
+        slots.clear();
+    }
+
+    void PhotonMap::build(std::vector<Photon> photons)
+    {
+        this->photons = std::move(photons);
+        slots.clear();
+
+        if (passes == 0)
+        {
+            // nothing focused into view yet to size the first radius by, so the progression has not started
+            if (this->photons.empty())
+            {
+                return;
+            }
+
+            auto distances = std::vector<Real>(this->photons.size());
+            std::transform(std::execution::par, this->photons.begin(), this->photons.end(), distances.begin(), [&](const Photon& photon)
+            {
+                return glm::distance(photon.position, camera);
+            });
+
+            const auto median = distances.begin() + distances.size() / 2;
+            std::nth_element(distances.begin(), median, distances.end());
+
+            radius = INITIAL_SPACING * pixel_angle * *median;
+        }
+        else
+        {
+            // a pass without photons is still one of those averaged, so it shrinks the radius all the same
+            radius *= glm::sqrt((static_cast<Real>(passes) + ALPHA) / static_cast<Real>(passes + 1));
+        }
+
+        passes++;
+
+        if (this->photons.empty() || !(radius > 0.f))
+        {
+            this->photons.clear();
+            return;
+        }
+
+        // about two slots per photon keeps runs of unrelated cells sharing a slot short
+        slots.assign(std::bit_ceil(2 * this->photons.size()), std::pair{ EMPTY, EMPTY });
+
+        keys.resize(this->photons.size());
+        std::for_each(std::execution::par, keys.begin(), keys.end(), [&](auto& key)
+        {
+            const auto index = static_cast<std::uint32_t>(&key - keys.data());
+            key = std::pair{ slot_of(cell_of(this->photons[index].position)), index };
+        });
+
+        std::sort(std::execution::par, keys.begin(), keys.end());
+
+        auto sorted = std::vector<Photon>(this->photons.size());
+        std::for_each(std::execution::par, keys.begin(), keys.end(), [&](const auto& key)
+        {
+            const auto index = static_cast<std::uint32_t>(&key - keys.data());
+            sorted[index] = this->photons[key.second];
+
+            // every run is bounded by where its slot differs from its neighbours', which each position can tell alone
+            const auto slot = key.first;
+            if (index == 0 || keys[index - 1].first != slot)
+            {
+                slots[slot].first = index;
+            }
+
+            if (index + 1 == keys.size() || keys[index + 1].first != slot)
+            {
+                slots[slot].second = index + 1;
+            }
+        });
+
+        this->photons = std::move(sorted);
+    }
+
+    glm::vec3 PhotonMap::estimate(const glm::vec3& position, const glm::vec3& normal) const
+    {
+        if (photons.empty())
+        {
+            return glm::vec3{ 0.f };
+        }
+
+        const auto radius2 = radius * radius;
+        const auto minimum = cell_of(position - radius);
+        const auto maximum = cell_of(position + radius);
+
+        // neighbouring cells may share a slot, whose photons must only count once
+        auto visited = std::array<std::uint32_t, 8>{};
+        auto visits = 0uz;
+
+        auto flux = glm::vec3{ 0.f };
+        for (auto z = minimum.z; z <= maximum.z; z++)
+        {
+            for (auto y = minimum.y; y <= maximum.y; y++)
+            {
+                for (auto x = minimum.x; x <= maximum.x; x++)
+                {
+                    const auto slot = slot_of(glm::ivec3{ x, y, z });
+                    if (std::find(visited.begin(), visited.begin() + visits, slot) != visited.begin() + visits)
+                    {
+                        continue;
+                    }
+
+                    visited[visits++] = slot;
+
+                    const auto [first, last] = slots[slot];
+                    if (first == EMPTY)
+                    {
+                        continue;
+                    }
+
+                    for (auto i = first; i < last; i++)
+                    {
+                        const auto& photon = photons[i];
+                        const auto offset = photon.position - position;
+                        if (glm::dot(offset, offset) > radius2 || glm::dot(photon.normal, normal) < MINIMUM_COSINE)
+                        {
+                            continue;
+                        }
+
+                        flux += photon.power;
+                    }
+                }
+            }
+        }
+
+        return flux / (glm::pi<Real>() * radius2);
+    }
+}
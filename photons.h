@@ -0,0 +1,108 @@
+#ifndef IRRADIANCE_PHOTONS_H
+#define IRRADIANCE_PHOTONS_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// photons.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // light arriving at a diffuse surface after it left an emitter through near-specular surfaces only
+    struct Photon
+    {
+    public:
+        glm::vec3 position = glm::vec3{ 0.f };
+        // of the surface the photon landed on, facing the side it arrived from
+        glm::vec3 normal = glm::vec3{ 0.f };
+        // flux carried, already divided by the number of photons traced in its pass
+        glm::vec3 power = glm::vec3{ 0.f };
+    };
+
+    // caustic photons of a single pass, found through a hash grid whose cells are as wide as the gather radius.
+    // the grid is built in parallel by sorting the photons on the table slot of their cell, which leaves every slot
+    // holding one contiguous run. the radius shrinks from pass to pass, so that although each pass blurs its caustics
+    // the average over passes converges to them: progressive photon mapping in the probabilistic formulation
+    // https://www.cs.jhu.edu/~misha/ReadingSeminar/Papers/Knaus11.pdf
+    class PhotonMap
+    {
+    public:
+        // share of the photons within the radius kept by the next pass, trading how fast bias vanishes against noise
+        static constexpr Real ALPHA = 2.f / 3.f;
+        // radius of the first pass on screen, in pixels at the median distance of its photons from the camera
+        static constexpr Real INITIAL_SPACING = 4.f;
+        // least cosine between the normals of a photon and a point for it to count there, so light does not bleed
+        // around corners
+        static constexpr Real MINIMUM_COSINE = .5f;
+
+    private:
+        static constexpr std::uint32_t EMPTY = 0xffffffff;
+
+    private:
+        // photons traced per pass; zero disables the map
+        std::size_t count;
+        glm::vec3 camera = glm::vec3{ 0.f };
+        // angle subtended by one pixel
+        Real pixel_angle = 0.f;
+
+        Real radius = 0.f;
+        // since the last reset
+        std::uint32_t passes = 0;
+
+        // sorted by slot
+        std::vector<Photon> photons;
+        // first photon and one past the last of each slot, EMPTY for slots no photon fell into
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> slots;
+        // (slot, photon) for every photon, kept between passes only to reuse its storage
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> keys;
+
+    public:
+        PhotonMap(std::size_t count = 0)
+            : count{ count }
+        {
+        }
+
+    public:
+        // forgets the passes so far, as when the view changes, and measures the first radius from now on against the
+        // new camera
+        void reset(const glm::vec3& camera, Real pixel_angle);
+        // replaces the photons with those of a new pass, shrinking the radius
+        void build(std::vector<Photon> photons);
+        // flux per unit area arriving near the point, from the photons within the radius
+        glm::vec3 estimate(const glm::vec3& position, const glm::vec3& normal) const;
+
+    public:
+        bool enabled() const
+        {
+            return count > 0;
+        }
+
+        std::size_t photons_per_pass() const
+        {
+            return count;
+        }
+
+        // photons stored by the last pass
+        std::size_t size() const
+        {
+            return photons.size();
+        }
+
+        Real gather_radius() const
+        {
+            return radius;
+        }
+
+    private:
+        std::uint32_t slot_of(const glm::ivec3& cell) const;
+        glm::ivec3 cell_of(const glm::vec3& position) const;
+    };
+}
+
+#endif
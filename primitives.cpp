@@ -0,0 +1,676 @@
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/component_wise.hpp"
+
+#include "primitives.h"
+#include "renderer.h"
+#include "random.h"
+#include "volume.h"
+
+// primitives.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // Phase one: each test only establishes whether and where the ray hits, filling the slim Hit record.
+    // Phase two: the resolve_* counterparts evaluate the surface for the single nearest hit that survives traversal
+
+    bool intersect_triangle(const ir::IndexedTriangles& triangles, std::uint32_t face, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        // Modified Möller-Trumbore from https://en.m.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+        // with the vertices read through the index buffer. TrianglePackets cache the same edges when memory allows
+
+        const auto& v0 = triangles.position(face, 0);
+        const auto edge0 = triangles.position(face, 1) - v0;
+        const auto edge1 = triangles.position(face, 2) - v0;
+
+        const auto test = glm::cross(ray.direction, edge1);
+
+        // run Cramer's rule to intersect and get barycentric coordinates as UV
+        const auto determinant = glm::dot(edge0, test);
+        if (glm::abs(determinant) < .001f)
+        {
+            // parallel
+            return false;
+        }
+
+        const auto inverse_determinant = 1.f / determinant;
+        const auto difference = ray.origin - v0;
+        const auto u = glm::dot(difference, test) * inverse_determinant;
+
+        if (u < 0.f || u > 1.f)
+        {
+            // outside
+            return false;
+        }
+
+        const auto q = glm::cross(difference, edge0);
+        const auto v = glm::dot(ray.direction, q) * inverse_determinant;
+
+        if (v < 0.f || u + v > 1.f)
+        {
+            // outside
+            return false;
+        }
+
+        const auto t = glm::dot(edge1, q) * inverse_determinant;
+        if (t <= .001f || t >= t_max)
+        {
+            // behind or beyond
+            return false;
+        }
+
+        hit.depth = t;
+        hit.barycentric = { u, v };
+        return true;
+    }
+
+    ir::RayIntersection resolve_triangle(const ir::IndexedTriangles& triangles, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        const auto face = hit.primitive.index;
+        const auto i0 = triangles.indices[3 * face + 0];
+        const auto i1 = triangles.indices[3 * face + 1];
+        const auto i2 = triangles.indices[3 * face + 2];
+
+        // barycentric weights of each corner
+        const auto u = hit.barycentric.x;
+        const auto v = hit.barycentric.y;
+        const auto w = 1.f - u - v;
+
+        const auto& p0 = triangles.positions[i0];
+        auto normal = glm::normalize(glm::cross(triangles.positions[i1] - p0, triangles.positions[i2] - p0));
+
+        if (!triangles.normals.empty())
+        {
+            // smooth shading, falling back to the face normal if the vertex normals cancel out
+            const auto interpolated = w * triangles.normals[i0] + u * triangles.normals[i1] + v * triangles.normals[i2];
+            if (glm::dot(interpolated, interpolated) > 0.f)
+            {
+                normal = glm::normalize(interpolated);
+            }
+        }
+
+        const auto uv = triangles.uvs.empty() ? hit.barycentric : w * triangles.uvs[i0] + u * triangles.uvs[i1] + v * triangles.uvs[i2];
+
+        return
+        {
+            .position = ray.origin + ray.direction * hit.depth,
+            .normal = normal,
+            .material = &materials[triangles.face_materials[face]],
+            .depth = hit.depth,
+            .hit = true,
+            .object = triangles.face_objects[face],
+            .face = face,
+            .uv = uv,
+        };
+    }
+
+    bool intersect_sphere(const ir::SpherePrimitive& sphere, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        const auto difference = ray.origin - sphere.center;
+
+        const auto a = glm::dot(ray.direction, ray.direction);
+        const auto b = 2.f * glm::dot(difference, ray.direction);
+        const auto c = glm::dot(difference, difference) - (sphere.radius * sphere.radius);
+        const auto d = (b * b) - (4.f * a * c);
+
+        if (d > 0.f)
+        {
+            const auto t1 = (-b - glm::sqrt(d)) / (2.f * a);
+            const auto t2 = (-b + glm::sqrt(d)) / (2.f * a);
+
+            if (t1 > 0.f && t1 < t_max)
+            {
+                hit.depth = t1;
+                hit.exit = t2;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    ir::RayIntersection resolve_sphere(const ir::SpherePrimitive& sphere, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        const auto intersection = ray.origin + ray.direction * hit.depth;
+
+        const auto reverse = intersection - sphere.center;
+        const auto normal = glm::normalize(reverse);
+
+        // Spherical coordinates https://en.wikipedia.org/wiki/UV_mapping
+        const auto p = normal;
+
+        const auto u = .5f + glm::atan2(p.z, p.x) / (2.f * glm::pi<ir::Real>());
+        const auto v = .5f + glm::asin(p.y) / glm::pi<ir::Real>();
+
+        return
+        {
+            .position = intersection,
+            .normal = normal,
+            .material = &materials[sphere.object->material],
+            .depth = hit.depth,
+            .exit = hit.exit,
+            .hit = true,
+            .object = sphere.object,
+            .uv = { u, v },
+        };
+    }
+
+    bool intersect_quadrilateral(const ir::QuadrilateralPrimitive& quadrilateral, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        // quad intersection from https://raytracing.github.io/books/RayTracingTheNextWeek.html
+        // finds the plane containing the quad, then intersects the plane and verifies quad boundaries
+
+        const auto denominator = glm::dot(quadrilateral.normal, ray.direction);
+        if (glm::abs(denominator) < .001f)
+        {
+            // parallel
+            return false;
+        }
+
+        const auto t = (quadrilateral.constant - glm::dot(quadrilateral.normal, ray.origin)) / denominator;
+        if (t <= .001f || t >= t_max)
+        {
+            // behind or beyond
+            return false;
+        }
+
+        const auto plane_intersection = ray.origin + ray.direction * t - quadrilateral.v0;
+        // equivalent to the alpha, beta products in RTTNW quad algorithm
+        const auto u = glm::dot(quadrilateral.reciprocal, glm::cross(plane_intersection, quadrilateral.v1));
+        const auto v = glm::dot(quadrilateral.reciprocal, glm::cross(quadrilateral.v2, plane_intersection));
+
+        if (u < 0.f || u > 1.f || v < 0.f || v > 1.f)
+        {
+            // outside
+            return false;
+        }
+
+        hit.depth = t;
+        hit.barycentric = { u, v };
+        return true;
+    }
+
+    ir::RayIntersection resolve_quadrilateral(const ir::QuadrilateralPrimitive& quadrilateral, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        return
+        {
+            .position = ray.origin + ray.direction * hit.depth,
+            .normal = quadrilateral.normal,
+            .material = &materials[quadrilateral.object->material],
+            .depth = hit.depth,
+            .hit = true,
+            .object = quadrilateral.object,
+            .uv = hit.barycentric,
+        };
+    }
+
+    bool intersect_cuboid(const ir::CuboidPrimitive& cuboid, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        // slab method https://en.wikipedia.org/wiki/Slab_method
+        // modified into 3-D from https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-box-intersection.html
+
+        const auto reciprocal = 1.f / ray.direction;
+
+        const auto t0 = (cuboid.minimum - ray.origin) * reciprocal;
+        const auto t1 = (cuboid.maximum - ray.origin) * reciprocal;
+
+        const auto tmin = glm::compMax(glm::min(t0, t1));
+        const auto tmax = glm::compMin(glm::max(t0, t1));
+
+        if (tmax < 0.f || tmin > tmax)
+        {
+            return false;
+        }
+
+        const auto t = tmin >= 0.f ? tmin : tmax;
+        if (t > 0.f && t < t_max)
+        {
+            hit.depth = t;
+            hit.exit = tmax;
+            return true;
+        }
+
+        return false;
+    }
+
+    ir::RayIntersection resolve_cuboid(const ir::CuboidPrimitive& cuboid, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        auto intersection = ray.origin + ray.direction * hit.depth;
+        auto normal = ir::normal_of(cuboid, intersection);
+
+        intersection += normal * .001f;
+
+        const auto difference = intersection - (cuboid.minimum + cuboid.maximum) / 2.f;
+        // no idea if this is geometrically correct, but the same formula from the sphere seems to work okay :)
+        const auto u = .5f + glm::atan2(difference.z, difference.x) / (2.f * glm::pi<ir::Real>());
+        const auto v = .5f + glm::asin(difference.y / glm::length(difference)) / glm::pi<ir::Real>();
+
+        return
+        {
+            .position = intersection,
+            .normal = normal,
+            .material = &materials[cuboid.object->material],
+            .depth = hit.depth,
+            .exit = hit.exit,
+            .hit = true,
+            .object = cuboid.object,
+            .uv = { u, v },
+        };
+    }
+
+    bool intersect_quadric(const ir::QuadricPrimitive& quadric, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        [[maybe_unused]] const auto [A, B, C, D, E, F, G, H, I, J] = quadric.coefficients;
+
+        const auto& O = ray.origin;
+        const auto& R = ray.direction;
+        const auto& M = quadric.centroid;
+
+        const auto a = (A * R.x * R.x) + (B * R.y * R.y) + (C * R.z * R.z) +
+                       (D * R.x * R.y) + (E * R.x * R.z) + (F * R.y * R.z);
+
+        const auto b = (2.f * A * (O.x - M.x) * R.x) + (2.f * B * (O.y - M.y) * R.y) + (2.f * C * (O.z - M.z) * R.z) +
+                       (D * ((O.x - M.x) * R.y + (O.y - M.y) * R.x)) +
+                       (E * ((O.x - M.x) * R.z + (O.z - M.z) * R.x)) +
+                       (F * ((O.y - M.y) * R.z + (O.z - M.z) * R.y)) +
+                       (G * R.x + H * R.y + I * R.z);
+
+        const auto c = (A * (O.x - M.x) * (O.x - M.x)) + (B * (O.y - M.y) * (O.y - M.y)) + (C * (O.z - M.z) * (O.z - M.z)) +
+                       (D * (O.x - M.x) * (O.y - M.y)) +
+                       (E * (O.x - M.x) * (O.z - M.z)) +
+                       (F * (O.y - M.y) * (O.z - M.z)) +
+                       (G * (O.x - M.x) + H * (O.y - M.y) + I * (O.z - M.z)) + J;
+
+        const auto d = (b * b) - (4.f * a * c);
+
+        if (d > 0.f)
+        {
+            const auto t1 = (-b - glm::sqrt(d)) / (2.f * a);
+            const auto t2 = (-b + glm::sqrt(d)) / (2.f * a);
+
+            if (t1 > 0.f && t1 < t_max)
+            {
+                const auto intersection = ray.origin + ray.direction * t1;
+
+                // effectively clamp the quadric surface to the corresponding clip cube
+                if (!glm::any(glm::lessThan(intersection, quadric.minimum)) &&
+                    !glm::any(glm::greaterThan(intersection, quadric.maximum)))
+                {
+                    hit.depth = t1;
+                    hit.exit = t2;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    ir::RayIntersection resolve_quadric(const ir::QuadricPrimitive& quadric, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        const auto intersection = ray.origin + ray.direction * hit.depth;
+        auto normal = ir::normal_of(quadric, intersection);
+
+        const auto difference = intersection - (quadric.minimum + quadric.maximum) / 2.f;
+        // no idea if this is geometrically correct, but the same formula from the sphere seems to work okay :)
+        const auto u = .5f + glm::atan2(difference.z, difference.x) / (2.f * glm::pi<ir::Real>());
+        const auto v = .5f + glm::asin(difference.y / glm::length(difference)) / glm::pi<ir::Real>();
+
+        return
+        {
+            .position = intersection,
+            .normal = normal,
+            .material = &materials[quadric.object->material],
+            .depth = hit.depth,
+            .exit = hit.exit,
+            .hit = true,
+            .object = quadric.object,
+            .uv = { u, v },
+        };
+    }
+
+    // stretch of the ray inside a closed container, clipped to start no earlier than the origin, so that rays leaving
+    // from a scattering event inside a medium still travel through the rest of it
+    bool span(const ir::PrimitiveStore& store, ir::PrimitiveReference container, const ir::Ray& ray, ir::Real& entry, ir::Real& exit)
+    {
+        switch (container.type())
+        {
+            case ir::PrimitiveType::SPHERE:
+            {
+                const auto& sphere = store.spheres[container.index];
+                const auto difference = ray.origin - sphere.center;
+
+                const auto a = glm::dot(ray.direction, ray.direction);
+                const auto b = 2.f * glm::dot(difference, ray.direction);
+                const auto c = glm::dot(difference, difference) - (sphere.radius * sphere.radius);
+                const auto d = (b * b) - (4.f * a * c);
+                if (d <= 0.f)
+                {
+                    return false;
+                }
+
+                entry = (-b - glm::sqrt(d)) / (2.f * a);
+                exit = (-b + glm::sqrt(d)) / (2.f * a);
+                break;
+            }
+
+            case ir::PrimitiveType::CUBOID:
+            {
+                const auto& cuboid = store.cuboids[container.index];
+                const auto reciprocal = 1.f / ray.direction;
+
+                const auto t0 = (cuboid.minimum - ray.origin) * reciprocal;
+                const auto t1 = (cuboid.maximum - ray.origin) * reciprocal;
+
+                entry = glm::compMax(glm::min(t0, t1));
+                exit = glm::compMin(glm::max(t0, t1));
+                break;
+            }
+
+            default:
+            {
+                // other shapes only report the stretch beyond their nearest surface in front of the origin
+                auto boundary = ir::Hit{};
+                if (!ir::intersect(store, container, ray, std::numeric_limits<ir::Real>::infinity(), boundary))
+                {
+                    return false;
+                }
+
+                entry = boundary.depth;
+                exit = boundary.exit;
+                break;
+            }
+        }
+
+        entry = glm::max(entry, 0.f);
+        return exit > entry;
+    }
+
+    bool intersect_colloid(const ir::PrimitiveStore& store, const ir::ColloidPrimitive& colloid, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        // the boundary itself may lie beyond t_max while the scattering event does not, so it is found unbounded
+        auto entry = 0.f, exit = 0.f;
+        if (!span(store, colloid.container, ray, entry, exit))
+        {
+            return false;
+        }
+
+        const auto scatter_distance = (exit - entry) * glm::length(ray.direction);
+
+        // exponential falloff per https://raytracing.github.io/books/RayTracingTheNextWeek.html#volumes/constantdensitymediums
+        // 1 - u lies in (0, 1], so the logarithm stays finite
+        const auto random = 1.f - ir::rng().uniform();
+        const auto travel = -(1.f / colloid.density) * glm::log(random);
+
+        if (travel >= scatter_distance)
+        {
+            return false;
+        }
+
+        // travel is a distance, so convert it back into the ray parameter in case the direction is not unit length
+        const auto depth = entry + travel / glm::length(ray.direction);
+        if (depth <= 0.f || depth >= t_max)
+        {
+            return false;
+        }
+
+        hit.depth = depth;
+        hit.exit = 0.f;
+        hit.barycentric = { travel, 0.f };
+        return true;
+    }
+
+    ir::Real transmittance_colloid(const ir::PrimitiveStore& store, const ir::ColloidPrimitive& colloid, const ir::Ray& ray, ir::Real t_max)
+    {
+        auto entry = 0.f, exit = 0.f;
+        if (!span(store, colloid.container, ray, entry, exit) || entry >= t_max)
+        {
+            return 1.f;
+        }
+
+        // this is the chance that intersect_colloid() lets the ray through, exp(-density * length), and deliberately
+        // has no albedo in it. resolve_colloid() tints only the segment that ends in a scatter, and a ray that crosses
+        // without scattering is not tinted on the camera path either, so a shadow ray has no such segment to tint.
+        // homogeneous, so the density is its own control
+        return ratio_track(ray, entry, glm::min(exit, t_max), colloid.density, 0.f, [&](const glm::vec3&) { return colloid.density; });
+    }
+
+    ir::RayIntersection resolve_colloid(const ir::ColloidPrimitive& colloid, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        const auto travel = hit.barycentric.x;
+
+        // scatter randomly within the bounding media
+        const auto position = ray.origin + ray.direction * hit.depth;
+        const auto normal = ir::rng().sphere(1.f);
+
+        // handed back with the hit rather than written into the material, which every worker shares
+        const auto& material = materials[colloid.object->material];
+        const auto attenuation = glm::exp(-colloid.density * travel * material.albedo);
+
+        return
+        {
+            .position = position,
+            .normal = normal,
+            .material = &material,
+            .depth = hit.depth,
+            .hit = true,
+            .object = colloid.object,
+            .uv = { 0.f, 0.f },
+            .attenuation = attenuation,
+        };
+    }
+
+    bool intersect_volume(const ir::PrimitiveStore& store, const ir::VolumePrimitive& volume, const ir::Ray& ray, ir::Real t_max, ir::Hit& hit)
+    {
+        auto entry = 0.f, exit = 0.f;
+        if (!span(store, volume.container, ray, entry, exit) || entry >= t_max)
+        {
+            return false;
+        }
+
+        auto depth = 0.f;
+        if (!volume.grid->track(ray, entry, glm::min(exit, t_max), depth) || depth <= 0.f)
+        {
+            return false;
+        }
+
+        hit.depth = depth;
+        hit.exit = 0.f;
+        hit.barycentric = { (depth - entry) * glm::length(ray.direction), 0.f };
+        return true;
+    }
+
+    ir::Real transmittance_volume(const ir::PrimitiveStore& store, const ir::VolumePrimitive& volume, const ir::Ray& ray, ir::Real t_max)
+    {
+        auto entry = 0.f, exit = 0.f;
+        if (!span(store, volume.container, ray, entry, exit) || entry >= t_max)
+        {
+            return 1.f;
+        }
+
+        return volume.grid->transmittance(ray, entry, glm::min(exit, t_max));
+    }
+
+    ir::RayIntersection resolve_volume(const ir::VolumePrimitive& volume, const ir::MaterialTable& materials, const ir::Ray& ray, const ir::Hit& hit)
+    {
+        // a real collision already happened in proportion to the density along the way, so the albedo alone
+        // carries the throughput and no further attenuation is applied
+        return
+        {
+            .position = ray.origin + ray.direction * hit.depth,
+            .normal = ir::rng().sphere(1.f),
+            .material = &materials[volume.object->material],
+            .depth = hit.depth,
+            .hit = true,
+            .object = volume.object,
+            .uv = { 0.f, 0.f },
+        };
+    }
+}
+
+namespace ir
+{
+    PrimitiveReference PrimitiveStore::add(Object* object)
+    {
+        switch (object->type())
+        {
+            case PrimitiveType::SPHERE:
+                spheres.push_back(static_cast<Sphere*>(object)->compact());
+                return PrimitiveReference{ PrimitiveType::SPHERE, static_cast<std::uint32_t>(spheres.size() - 1) };
+
+            case PrimitiveType::QUADRILATERAL:
+                quadrilaterals.push_back(static_cast<Quadrilateral*>(object)->compact());
+                return PrimitiveReference{ PrimitiveType::QUADRILATERAL, static_cast<std::uint32_t>(quadrilaterals.size() - 1) };
+
+            case PrimitiveType::CUBOID:
+                cuboids.push_back(static_cast<Cuboid*>(object)->compact());
+                return PrimitiveReference{ PrimitiveType::CUBOID, static_cast<std::uint32_t>(cuboids.size() - 1) };
+
+            case PrimitiveType::QUADRIC:
+                quadrics.push_back(static_cast<Quadric*>(object)->compact());
+                return PrimitiveReference{ PrimitiveType::QUADRIC, static_cast<std::uint32_t>(quadrics.size() - 1) };
+
+            case PrimitiveType::COLLOID:
+            {
+                const auto colloid = static_cast<Colloid*>(object);
+                // the container must be compiled first so that its reference is known.
+                // NOTE: only closed shapes (spheres, cuboids, quadrics) have the exit distance a medium needs
+                const auto container = add(colloid->container);
+                colloids.push_back(ColloidPrimitive{ colloid->density, container, object });
+                return PrimitiveReference{ PrimitiveType::COLLOID, static_cast<std::uint32_t>(colloids.size() - 1) };
+            }
+
+            case PrimitiveType::VOLUME:
+            {
+                const auto volume = static_cast<Volume*>(object);
+                // the same closed containers as colloids
+                const auto container = add(volume->container);
+                volumes.push_back(VolumePrimitive{ &volume->grid, container, object });
+                return PrimitiveReference{ PrimitiveType::VOLUME, static_cast<std::uint32_t>(volumes.size() - 1) };
+            }
+
+            case PrimitiveType::TRIANGLE:
+            {
+                // appended to the indexed buffers with its own three vertices, keeping any vertex attributes parallel
+                const auto triangle = static_cast<Triangle*>(object);
+                const auto first = static_cast<std::uint32_t>(triangles.positions.size());
+
+                triangles.positions.insert(triangles.positions.end(), { triangle->v0, triangle->v1, triangle->v2 });
+                if (!triangles.normals.empty())
+                {
+                    triangles.normals.insert(triangles.normals.end(), 3, triangle->normal);
+                }
+                if (!triangles.uvs.empty())
+                {
+                    triangles.uvs.insert(triangles.uvs.end(), { triangle->uv0, triangle->uv1, triangle->uv2 });
+                }
+
+                triangles.indices.insert(triangles.indices.end(), { first, first + 1, first + 2 });
+                triangles.face_materials.push_back(triangle->material);
+                triangles.face_objects.push_back(object);
+                return PrimitiveReference{ PrimitiveType::TRIANGLE, static_cast<std::uint32_t>(triangles.size() - 1) };
+            }
+        }
+
+        return PrimitiveReference{};
+    }
+
+    bool intersect(const PrimitiveStore& store, PrimitiveReference reference, const Ray& ray, Real t_max, Hit& hit)
+    {
+        switch (reference.type())
+        {
+            case PrimitiveType::TRIANGLE: return intersect_triangle(store.triangles, reference.index, ray, t_max, hit);
+            case PrimitiveType::SPHERE: return intersect_sphere(store.spheres[reference.index], ray, t_max, hit);
+            case PrimitiveType::QUADRILATERAL: return intersect_quadrilateral(store.quadrilaterals[reference.index], ray, t_max, hit);
+            case PrimitiveType::CUBOID: return intersect_cuboid(store.cuboids[reference.index], ray, t_max, hit);
+            case PrimitiveType::QUADRIC: return intersect_quadric(store.quadrics[reference.index], ray, t_max, hit);
+            case PrimitiveType::COLLOID: return intersect_colloid(store, store.colloids[reference.index], ray, t_max, hit);
+            case PrimitiveType::VOLUME: return intersect_volume(store, store.volumes[reference.index], ray, t_max, hit);
+        }
+
+        return false;
+    }
+
+    Real transmittance(const PrimitiveStore& store, PrimitiveReference reference, const Ray& ray, Real t_max)
+    {
+        switch (reference.type())
+        {
+            case PrimitiveType::COLLOID: return transmittance_colloid(store, store.colloids[reference.index], ray, t_max);
+            case PrimitiveType::VOLUME: return transmittance_volume(store, store.volumes[reference.index], ray, t_max);
+
+            default:
+            {
+                auto hit = Hit{};
+                return intersect(store, reference, ray, t_max, hit) ? 0.f : 1.f;
+            }
+        }
+    }
+
+    RayIntersection resolve(const PrimitiveStore& store, const MaterialTable& materials, const Hit& hit, const Ray& ray)
+    {
+        const auto index = hit.primitive.index;
+
+        switch (hit.primitive.type())
+        {
+            case PrimitiveType::TRIANGLE: return resolve_triangle(store.triangles, materials, ray, hit);
+            case PrimitiveType::SPHERE: return resolve_sphere(store.spheres[index], materials, ray, hit);
+            case PrimitiveType::QUADRILATERAL: return resolve_quadrilateral(store.quadrilaterals[index], materials, ray, hit);
+            case PrimitiveType::CUBOID: return resolve_cuboid(store.cuboids[index], materials, ray, hit);
+            case PrimitiveType::QUADRIC: return resolve_quadric(store.quadrics[index], materials, ray, hit);
+            case PrimitiveType::COLLOID: return resolve_colloid(store.colloids[index], materials, ray, hit);
+            case PrimitiveType::VOLUME: return resolve_volume(store.volumes[index], materials, ray, hit);
+        }
+
+        return RayIntersection{};
+    }
+
+    glm::vec3 normal_of(const CuboidPrimitive& cuboid, const glm::vec3& position)
+    {
+        // compute unit-vector normals depending upon the face (since it is axis-aligned)
+
+        if (glm::abs(position.x - cuboid.minimum.x) < .001f)
+        {
+            return glm::vec3{ -1.f, 0.f, 0.f };
+        }
+        else if (glm::abs(position.x - cuboid.maximum.x) < .001f)
+        {
+            return glm::vec3{ 1.f, 0.f, 0.f };
+        }
+        else if (glm::abs(position.y - cuboid.minimum.y) < .001f)
+        {
+            return glm::vec3{ 0.f, -1.f, 0.f };
+        }
+        else if (glm::abs(position.y - cuboid.maximum.y) < .001f)
+        {
+            return glm::vec3{ 0.f, 1.f, 0.f };
+        }
+        else if (glm::abs(position.z - cuboid.minimum.z) < .001f)
+        {
+            return glm::vec3{ 0.f, 0.f, -1.f };
+        }
+        else if (glm::abs(position.z - cuboid.maximum.z) < .001f)
+        {
+            return glm::vec3{ 0.f, 0.f, 1.f };
+        }
+
+        return glm::vec3{ 0.f };
+    }
+
+    glm::vec3 normal_of(const QuadricPrimitive& quadric, const glm::vec3& position)
+    {
+        // derivatives of the quadric function
+        // d/dx = 2Ax + Dy + Ez + G = 0
+        // d/dy = 2By + Dx + Fz + H = 0
+        // d/dz = 2Cz + Ex + Fy + I = 0
+
+        [[maybe_unused]] const auto [A, B, C, D, E, F, G, H, I, J] = quadric.coefficients;
+        const auto& centroid = quadric.centroid;
+
+        return glm::normalize(glm::vec3
+        {
+            2.f * A * (position.x - centroid.x) + D * (position.y - centroid.y) + E * (position.z - centroid.z) + G,
+            2.f * B * (position.y - centroid.y) + D * (position.x - centroid.x) + F * (position.z - centroid.z) + H,
+            2.f * C * (position.z - centroid.z) + E * (position.x - centroid.x) + F * (position.y - centroid.y) + I,
+        });
+    }
+}
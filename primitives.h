@@ -0,0 +1,197 @@
+#ifndef IRRADIANCE_PRIMITIVES_H
+#define IRRADIANCE_PRIMITIVES_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+#include "hierarchy.h"
+#include "material.h"
+
+// primitives.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    class DensityGrid;
+
+    // closed set of primitive kinds that the renderer intersects directly, without going through Object
+    enum class PrimitiveType : std::uint32_t
+    {
+        TRIANGLE,
+        SPHERE,
+        QUADRILATERAL,
+        CUBOID,
+        QUADRIC,
+        COLLOID,
+        VOLUME,
+    };
+
+    // type tag and index into the matching array of a PrimitiveStore, packed into a single word.
+    // for triangles the index is the face within the store's IndexedTriangles
+    struct PrimitiveReference
+    {
+    public:
+        std::uint32_t tag : 3;
+        std::uint32_t index : 29;
+
+    public:
+        PrimitiveReference()
+            : tag{ 0 }, index{ 0 }
+        {
+        }
+
+        PrimitiveReference(PrimitiveType type, std::uint32_t index)
+            : tag{ static_cast<std::uint32_t>(type) }, index{ index }
+        {
+        }
+
+    public:
+        PrimitiveType type() const
+        {
+            return static_cast<PrimitiveType>(tag);
+        }
+    };
+
+    // compact intersection-only forms of the authoring classes in renderer.h. each keeps just the geometry
+    // needed by the intersection test plus a pointer back to its authoring object for the surface record
+
+    // triangles sharing one vertex buffer, addressed through a compact index buffer. shared vertices are
+    // stored once rather than copied into every face that uses them
+    struct IndexedTriangles
+    {
+    public:
+        std::vector<glm::vec3> positions;
+        // optional per-vertex attributes, either empty or parallel to positions. without normals faces are
+        // flat shaded, and without UVs the barycentric coordinates stand in for them
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        // three vertex indices per face
+        std::vector<std::uint32_t> indices;
+        std::vector<MaterialId> face_materials;
+        // authoring triangle each face was added from, parallel to face_materials and null for faces loaded from a file
+        std::vector<Object*> face_objects;
+
+    public:
+        std::size_t size() const
+        {
+            return face_materials.size();
+        }
+
+        const glm::vec3& position(std::uint32_t face, std::uint32_t corner) const
+        {
+            return positions[indices[3 * face + corner]];
+        }
+
+        BoundingVolume bounds(std::uint32_t face) const
+        {
+            const auto minimum = glm::min(position(face, 0), glm::min(position(face, 1), position(face, 2)));
+            const auto maximum = glm::max(position(face, 0), glm::max(position(face, 1), position(face, 2)));
+
+            return BoundingVolume{ minimum, maximum - minimum };
+        }
+
+        glm::vec3 centroid(std::uint32_t face) const
+        {
+            return (position(face, 0) + position(face, 1) + position(face, 2)) / 3.f;
+        }
+    };
+
+    struct SpherePrimitive
+    {
+        glm::vec3 center;
+        Real radius;
+        Object* object;
+    };
+
+    struct QuadrilateralPrimitive
+    {
+        glm::vec3 v0, v1, v2;
+        glm::vec3 normal;
+        Real constant;
+        glm::vec3 reciprocal;
+        Object* object;
+    };
+
+    struct CuboidPrimitive
+    {
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        Object* object;
+    };
+
+    struct QuadricPrimitive
+    {
+        // A through J in the order of Quadric
+        std::array<Real, 10> coefficients;
+        glm::vec3 centroid;
+        // clip cube
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        Object* object;
+    };
+
+    struct ColloidPrimitive
+    {
+        Real density;
+        // the container is compiled into the same store but is never referenced by a hierarchy leaf itself
+        PrimitiveReference container;
+        Object* object;
+    };
+
+    struct VolumePrimitive
+    {
+        // owned by the authoring Volume, which outlives the store
+        const DensityGrid* grid;
+        PrimitiveReference container;
+        Object* object;
+    };
+
+    // per-type contiguous arrays of compact primitives
+    struct PrimitiveStore
+    {
+    public:
+        IndexedTriangles triangles;
+        std::vector<SpherePrimitive> spheres;
+        std::vector<QuadrilateralPrimitive> quadrilaterals;
+        std::vector<CuboidPrimitive> cuboids;
+        std::vector<QuadricPrimitive> quadrics;
+        std::vector<ColloidPrimitive> colloids;
+        std::vector<VolumePrimitive> volumes;
+
+    public:
+        // compiles an authoring object into the array for its type
+        PrimitiveReference add(Object* object);
+    };
+
+    // the only state carried through traversal. surface position, normal, UV and material are evaluated
+    // once for the final nearest hit by resolve(), so rejected candidates never pay for them
+    struct Hit
+    {
+        Real depth = std::numeric_limits<Real>::infinity();
+        // far side of closed primitives
+        Real exit = 0.f;
+        PrimitiveReference primitive;
+        // triangles and quadrilaterals: surface coordinates; colloids and volumes: x is the distance travelled through the medium
+        glm::vec2 barycentric = glm::vec2{ 0.f };
+    };
+
+    // dispatch on the type tag; a switch over a closed set rather than a virtual call per primitive.
+    // returns true and fills the depth, exit and barycentric of hit if the primitive lies in front of t_max.
+    // nothing beyond that is computed, so this doubles as the any-hit test for shadow rays
+    bool intersect(const PrimitiveStore& store, PrimitiveReference reference, const Ray& ray, Real t_max, Hit& hit);
+    // fraction of light that makes it through the primitive in front of t_max: an estimate for media, and zero or one
+    // for surfaces
+    Real transmittance(const PrimitiveStore& store, PrimitiveReference reference, const Ray& ray, Real t_max);
+    // builds the surface record for a hit found by intersect() with the same ray
+    RayIntersection resolve(const PrimitiveStore& store, const MaterialTable& materials, const Hit& hit, const Ray& ray);
+
+    glm::vec3 normal_of(const CuboidPrimitive& cuboid, const glm::vec3& position);
+    glm::vec3 normal_of(const QuadricPrimitive& quadric, const glm::vec3& position);
+}
+
+#endif
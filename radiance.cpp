@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "radiance.h"
+#include "random.h"
+
+// radiance.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    // bits per axis of a cell's coordinates, which wrap around far enough out that aliasing cells never meet
+    constexpr auto COORDINATE_BITS = 17;
+    constexpr auto COORDINATE_MASK = (std::uint64_t{ 1 } << COORDINATE_BITS) - 1;
+    // levels of cell size, each a power of two, centred on cells one unit wide
+    constexpr auto LEVELS = 64;
+    // set in every key so that no real key equals the empty one
+    constexpr auto OCCUPIED = std::uint64_t{ 1 } << 63;
+
+    // the axis the normal leans along most, and which way, as one of six faces
+    std::uint64_t face_of(const glm::vec3& normal)
+    {
+        const auto magnitude = glm::abs(normal);
+        const auto axis = magnitude.x > magnitude.y ? (magnitude.x > magnitude.z ? 0 : 2) : (magnitude.y > magnitude.z ? 1 : 2);
+
+        return static_cast<std::uint64_t>(2 * axis + (normal[axis] < 0.f));
+    }
+}
+
+namespace ir
+{
+    RadianceCache::RadianceCache(bool enabled)
+        : cells(enabled ? CAPACITY : 0)
+    {
+    }
+
+    std::uint64_t RadianceCache::key_of(const glm::vec3& position, const glm::vec3& normal) const
+    {
+        // cells grow with distance from the camera, keeping roughly the same size on screen
+        const auto width = glm::distance(position, camera) * pixel_angle * CELL_SPACING;
+        const auto level = std::clamp(static_cast<int>(glm::ceil(glm::log2(glm::max(width, std::numeric_limits<Real>::min())))), -LEVELS / 2, LEVELS / 2 - 1);
+
+        const auto cell = glm::ivec3{ glm::floor(position / std::ldexp(1.f, level)) };
+
+        auto key = OCCUPIED;
+        key |= static_cast<std::uint64_t>(level + LEVELS / 2) << (3 * COORDINATE_BITS + 3);
+        key |= (static_cast<std::uint64_t>(cell.x) & COORDINATE_MASK) << (2 * COORDINATE_BITS + 3);
+        key |= (static_cast<std::uint64_t>(cell.y) & COORDINATE_MASK) << (COORDINATE_BITS + 3);
+        key |= (static_cast<std::uint64_t>(cell.z) & COORDINATE_MASK) << 3;
+        key |= face_of(normal);
+
+        return key;
+    }
+
+    RadianceCache::Cell* RadianceCache::find(std::uint64_t key, bool claim)
+    {
+        const auto first = (mix(key) % (CAPACITY / BUCKET_SIZE)) * BUCKET_SIZE;
+
+        // evictions leave holes anywhere in the bucket, so the whole of it is searched before claiming one
+        auto* vacant = static_cast<Cell*>(nullptr);
+        for (auto i = first; i < first + BUCKET_SIZE; i++)
+        {
+            const auto existing = cells[i].key.load(std::memory_order_relaxed);
+            if (existing == key)
+            {
+                return &cells[i];
+            }
+
+            if (existing == EMPTY && !vacant)
+            {
+                vacant = &cells[i];
+            }
+        }
+
+        if (!claim || !vacant)
+        {
+            return nullptr;
+        }
+
+        // another worker may claim the same slot first, possibly for this very key
+        auto expected = EMPTY;
+        if (vacant->key.compare_exchange_strong(expected, key, std::memory_order_relaxed) || expected == key)
+        {
+            return vacant;
+        }
+
+        // a full bucket drops the sample
+        return nullptr;
+    }
+
+    void RadianceCache::resolve(const glm::vec3& camera, Real pixel_angle)
+    {
+        this->camera = camera;
+        this->pixel_angle = pixel_angle;
+
+        occupied = 0;
+
+        for (auto& cell : cells)
+        {
+            if (cell.key.load(std::memory_order_relaxed) == EMPTY)
+            {
+                continue;
+            }
+
+            if (frame - cell.frame.load(std::memory_order_relaxed) > STALE_FRAMES)
+            {
+                cell.key.store(EMPTY, std::memory_order_relaxed);
+                for (auto& sum : cell.sums)
+                {
+                    sum.store(0, std::memory_order_relaxed);
+                }
+                cell.count.store(0, std::memory_order_relaxed);
+                cell.radiance = glm::vec3{ 0.f };
+                cell.samples = 0;
+                continue;
+            }
+
+            occupied++;
+
+            const auto count = cell.count.exchange(0, std::memory_order_relaxed);
+            if (count == 0)
+            {
+                continue;
+            }
+
+            auto sum = glm::vec3{ 0.f };
+            for (auto channel = 0; channel < 3; channel++)
+            {
+                sum[channel] = static_cast<Real>(cell.sums[channel].exchange(0, std::memory_order_relaxed)) / FIXED_POINT_SCALE;
+            }
+
+            // running mean over at most MAXIMUM_SAMPLES, weighting the new samples by their number
+            const auto samples = std::min(cell.samples, MAXIMUM_SAMPLES);
+            const auto total = samples + count;
+            cell.radiance = (cell.radiance * static_cast<Real>(samples) + sum) / static_cast<Real>(total);
+            cell.samples = total;
+        }
+
+        frame++;
+    }
+
+    bool RadianceCache::lookup(const glm::vec3& position, const glm::vec3& normal, glm::vec3& radiance)
+    {
+        auto* const cell = find(key_of(position, normal), false);
+        if (!cell)
+        {
+            return false;
+        }
+
+        // in use, so not to be evicted even if paths stop updating it because they now end here
+        cell->frame.store(frame, std::memory_order_relaxed);
+
+        if (cell->samples < MINIMUM_SAMPLES)
+        {
+            return false;
+        }
+
+        radiance = cell->radiance;
+        return true;
+    }
+
+    void RadianceCache::update(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& radiance)
+    {
+        if (glm::any(glm::isnan(radiance)) || glm::any(glm::isinf(radiance)))
+        {
+            return;
+        }
+
+        auto* const cell = find(key_of(position, normal), true);
+        if (!cell)
+        {
+            return;
+        }
+
+        const auto clamped = glm::clamp(radiance, glm::vec3{ 0.f }, glm::vec3{ MAXIMUM_RADIANCE });
+        for (auto channel = 0; channel < 3; channel++)
+        {
+            cell->sums[channel].fetch_add(static_cast<std::uint64_t>(clamped[channel] * FIXED_POINT_SCALE + .5f), std::memory_order_relaxed);
+        }
+
+        cell->count.fetch_add(1, std::memory_order_relaxed);
+        cell->frame.store(frame, std::memory_order_relaxed);
+    }
+}
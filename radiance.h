@@ -0,0 +1,97 @@
+#ifndef IRRADIANCE_RADIANCE_H
+#define IRRADIANCE_RADIANCE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// radiance.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // radiance leaving surfaces, averaged over cells of quantized position and normal, so that deep paths can end in
+    // the cache instead of tracing bounces that contribute little. cells are found through a fixed table of buckets
+    // without locks: render workers claim empty slots with a compare-and-swap and add their samples atomically,
+    // while resolve() folds them into the estimates between frames and evicts cells nobody has touched in a while
+    // https://github.com/NVIDIAGameWorks/SHARC
+    class RadianceCache
+    {
+    public:
+        static constexpr std::size_t CAPACITY = std::size_t{ 1 } << 18;
+        // slots searched for a cell; a cell never moves out of the bucket its key hashes to, so eviction leaves no
+        // probe chains to repair
+        static constexpr std::size_t BUCKET_SIZE = 16;
+        // width of a cell on screen, in pixels at its distance from the camera
+        static constexpr Real CELL_SPACING = 8.f;
+        // samples a cell needs before paths may end in it
+        static constexpr std::uint32_t MINIMUM_SAMPLES = 16;
+        // beyond this many samples older ones are forgotten, so that estimates fed by a cache still warming up die out
+        static constexpr std::uint32_t MAXIMUM_SAMPLES = 1024;
+        // frames without a lookup or an update after which a cell is evicted
+        static constexpr std::uint32_t STALE_FRAMES = 32;
+
+    private:
+        // samples are summed in fixed point, since atomic floating-point addition is not available everywhere
+        static constexpr Real FIXED_POINT_SCALE = 65536.f;
+        // keeps a single sample from overflowing the sums of a cell
+        static constexpr Real MAXIMUM_RADIANCE = 1e6f;
+        static constexpr std::uint64_t EMPTY = 0;
+
+        struct Cell
+        {
+            std::atomic<std::uint64_t> key{ EMPTY };
+            // this frame's samples, not yet folded into the estimate
+            std::array<std::atomic<std::uint64_t>, 3> sums{};
+            std::atomic<std::uint32_t> count{ 0 };
+            std::atomic<std::uint32_t> frame{ 0 };
+            // written only by resolve(), so workers may read them freely during the frame
+            glm::vec3 radiance = glm::vec3{ 0.f };
+            std::uint32_t samples = 0;
+        };
+
+    private:
+        std::vector<Cell> cells;
+        glm::vec3 camera = glm::vec3{ 0.f };
+        // angle subtended by one pixel
+        Real pixel_angle = 0.f;
+        std::uint32_t frame = 0;
+        std::size_t occupied = 0;
+
+    public:
+        // the table is only allocated when enabled
+        RadianceCache(bool enabled = false);
+
+    public:
+        // between frames: folds the samples of the last frame into the estimates, evicts stale cells, and sizes the
+        // cells of the next frame for the given camera
+        void resolve(const glm::vec3& camera, Real pixel_angle);
+        // the estimate of the cell containing the point, if it has enough samples
+        bool lookup(const glm::vec3& position, const glm::vec3& normal, glm::vec3& radiance);
+        // adds a sample of the radiance leaving the point, claiming a cell for it if there is none yet
+        void update(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& radiance);
+
+    public:
+        bool enabled() const
+        {
+            return !cells.empty();
+        }
+
+        // cells in use as of the last resolve()
+        std::size_t size() const
+        {
+            return occupied;
+        }
+
+    private:
+        std::uint64_t key_of(const glm::vec3& position, const glm::vec3& normal) const;
+        Cell* find(std::uint64_t key, bool claim);
+    };
+}
+
+#endif
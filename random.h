@@ -0,0 +1,163 @@
+#ifndef IRRADIANCE_RANDOM_H
+#define IRRADIANCE_RANDOM_H
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include "utility.h"
+
+// random.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // warps from a point u in the unit square, so that any source of [0, 1)^2 samples can drive them
+
+    // uniform over the area of a disk in the xy plane
+    inline glm::vec2 sample_disk(const glm::vec2& u, Real radius)
+    {
+        const auto r = radius * glm::sqrt(u.x);
+        const auto phi = 2.f * glm::pi<Real>() * u.y;
+        return glm::vec2{ r * glm::cos(phi), r * glm::sin(phi) };
+    }
+
+    // uniform over the surface of a sphere
+    inline glm::vec3 sample_sphere(const glm::vec2& u, Real radius)
+    {
+        const auto z = 1.f - 2.f * u.x;
+        const auto r = glm::sqrt(glm::max(0.f, 1.f - z * z));
+        const auto phi = 2.f * glm::pi<Real>() * u.y;
+        return radius * glm::vec3{ r * glm::cos(phi), r * glm::sin(phi), z };
+    }
+
+    // uniform over the unit hemisphere on the side that normal points to
+    inline glm::vec3 sample_hemisphere(const glm::vec2& u, const glm::vec3& normal)
+    {
+        const auto direction = sample_sphere(u, 1.f);
+        return glm::dot(direction, normal) < 0.f ? -direction : direction;
+    }
+
+    // cosine-weighted over the unit hemisphere around +z by projecting the disk up (Malley's method)
+    // https://www.rorydriscoll.com/2009/01/07/better-sampling/
+    inline glm::vec3 sample_cosine_hemisphere(const glm::vec2& u)
+    {
+        const auto point = sample_disk(u, 1.f);
+        const auto z = glm::sqrt(glm::max(0.f, 1.f - point.x * point.x - point.y * point.y));
+        return glm::vec3{ point.x, point.y, z };
+    }
+
+    // PCG32 https://www.pcg-random.org/download.html
+    // 64 bits of state plus a stream selector, so that every pixel can draw from its own independent sequence
+    class Random
+    {
+    private:
+        std::uint64_t state = 0x853c49e6748fea9bull;
+        // must be odd
+        std::uint64_t increment = 0xda3e39cb94b95bdbull;
+
+    public:
+        Random() = default;
+        Random(std::uint64_t seed, std::uint64_t stream)
+        {
+            this->seed(seed, stream);
+        }
+
+    public:
+        void seed(std::uint64_t seed, std::uint64_t stream)
+        {
+            state = 0;
+            increment = (stream << 1) | 1;
+            next();
+            state += seed;
+            next();
+        }
+
+        std::uint32_t next()
+        {
+            const auto previous = state;
+            state = previous * 6364136223846793005ull + increment;
+
+            const auto xorshifted = static_cast<std::uint32_t>(((previous >> 18) ^ previous) >> 27);
+            const auto rotation = static_cast<std::uint32_t>(previous >> 59);
+            return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+        }
+
+    public:
+        // [0, 1) from the upper 24 bits, which is every value a float can represent evenly in that range
+        Real uniform()
+        {
+            return static_cast<Real>(next() >> 8) * 0x1p-24f;
+        }
+
+        Real uniform(Real minimum, Real maximum)
+        {
+            return minimum + (maximum - minimum) * uniform();
+        }
+
+        glm::vec3 uniform(const glm::vec3& minimum, const glm::vec3& maximum)
+        {
+            const auto x = uniform();
+            const auto y = uniform();
+            const auto z = uniform();
+            return minimum + (maximum - minimum) * glm::vec3{ x, y, z };
+        }
+
+        // [0, count) by multiply-shift https://arxiv.org/abs/1805.10941, without the modulo bias of rand() % count
+        std::uint32_t integer(std::uint32_t count)
+        {
+            return static_cast<std::uint32_t>((static_cast<std::uint64_t>(next()) * count) >> 32);
+        }
+
+    public:
+        glm::vec2 disk(Real radius)
+        {
+            const auto u = uniform();
+            return sample_disk(glm::vec2{ u, uniform() }, radius);
+        }
+
+        glm::vec3 sphere(Real radius)
+        {
+            const auto u = uniform();
+            return sample_sphere(glm::vec2{ u, uniform() }, radius);
+        }
+
+        glm::vec3 hemisphere(const glm::vec3& normal)
+        {
+            const auto u = uniform();
+            return sample_hemisphere(glm::vec2{ u, uniform() }, normal);
+        }
+
+        glm::vec3 cosine_hemisphere()
+        {
+            const auto u = uniform();
+            return sample_cosine_hemisphere(glm::vec2{ u, uniform() });
+        }
+    };
+
+    // generator of the calling thread. render workers reseed it per pixel and frame (see seed_pixel)
+    // so that every frame is reproducible no matter which thread renders which pixel
+    inline Random& rng()
+    {
+        thread_local auto generator = Random{};
+        return generator;
+    }
+
+    // decorrelates the per-frame seeds of a run before they are handed to PCG
+    // https://prng.di.unimi.it/splitmix64.c
+    inline std::uint64_t mix(std::uint64_t value)
+    {
+        value += 0x9e3779b97f4a7c15ull;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    }
+
+    inline void seed_pixel(std::uint64_t seed, std::uint64_t frame, std::uint64_t pixel)
+    {
+        rng().seed(mix(seed ^ mix(frame)), pixel);
+    }
+}
+
+#endif
@@ -1,90 +1,251 @@
 #include <fstream>
+#include <map>
+#include <array>
+#include <algorithm>
 #include <cctype>
+#include <stdexcept>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/compatibility.hpp"
-#include "glm/gtc/random.hpp"
-
 #include "renderer.h"
+#include "random.h"
 
 // renderer.cpp
 // (c) 2025 Connor J. Link. All Rights Reserved.
 
-namespace 
+namespace
 {
-    static constexpr ir::RayIntersection MISS = 
-    {
-        .position = glm::vec3{},
-        .normal = glm::vec3{},
-        .material = ir::PBRMaterial{},
-        .depth = std::numeric_limits<ir::Real>::infinity(),
-        .hit = false,
-    };
+    using ir::Real;
+
+    // spherical triangles subtending less than this are sampled by area instead, since the spherical construction
+    // loses all its precision in single floats; more than this and they are too close to a full hemisphere to be stable
+    // https://pbr-book.org/4ed/Shapes/Triangle_Meshes#TriangleSampling
+    constexpr auto MINIMUM_SOLID_ANGLE = 3e-4f;
+    constexpr auto MAXIMUM_SOLID_ANGLE = 6.22f;
+
+    // sin^2 of the half angle (about 1.5 degrees) below which sphere cones are expanded to first order
+    constexpr auto SMALL_CONE = .00068523f;
+
+    // how far a point may be from the crossing found again through it and still count as the same point,
+    // as a fraction of the container
+    constexpr auto QUADRIC_TOLERANCE = 1e-4f;
+
+    // the quadric function and its gradient, which are taken about the centroid as in intersect_quadric
+    Real evaluate(const ir::Quadric& quadric, const glm::vec3& position)
+    {
+        const auto offset = position - quadric.centroid;
+        const auto x = offset.x, y = offset.y, z = offset.z;
+        const auto& q = quadric;
+
+        return (q.A * x * x) + (q.B * y * y) + (q.C * z * z) + (q.D * x * y) + (q.E * x * z) + (q.F * y * z) +
+               (q.G * x) + (q.H * y) + (q.I * z) + q.J;
+    }
+
+    glm::vec3 gradient_of(const ir::Quadric& quadric, const glm::vec3& position)
+    {
+        const auto offset = position - quadric.centroid;
+        const auto x = offset.x, y = offset.y, z = offset.z;
+        const auto& q = quadric;
+
+        return glm::vec3
+        {
+            2.f * q.A * x + q.D * y + q.E * z + q.G,
+            2.f * q.B * y + q.D * x + q.F * z + q.H,
+            2.f * q.C * z + q.E * x + q.F * y + q.I,
+        };
+    }
+
+    // angle between unit vectors, accurate even when they are nearly parallel or opposite
+    Real angle_between(const glm::vec3& a, const glm::vec3& b)
+    {
+        if (glm::dot(a, b) < 0.f)
+        {
+            return glm::pi<Real>() - 2.f * glm::asin(glm::min(glm::length(a + b) / 2.f, 1.f));
+        }
+
+        return 2.f * glm::asin(glm::min(glm::length(b - a) / 2.f, 1.f));
+    }
+
+    // removes the part of v along unit w
+    glm::vec3 orthogonalize(const glm::vec3& v, const glm::vec3& w)
+    {
+        return v - glm::dot(v, w) * w;
+    }
+
+    // solid angle subtended at reference by the triangle v0 v1 v2
+    // https://en.wikipedia.org/wiki/Solid_angle#Tetrahedron
+    Real spherical_triangle_area(const glm::vec3& reference, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+    {
+        const auto a = glm::normalize(v0 - reference);
+        const auto b = glm::normalize(v1 - reference);
+        const auto c = glm::normalize(v2 - reference);
+
+        auto area = glm::abs(2.f * glm::atan(glm::dot(a, glm::cross(b, c)), 1.f + glm::dot(a, b) + glm::dot(a, c) + glm::dot(b, c)));
+        if (glm::isnan(area))
+        {
+            area = 0.f;
+        }
+
+        return area;
+    }
+
+    // barycentric coordinates of a direction uniform over the solid angle of the triangle v0 v1 v2 as seen from reference
+    // https://www.graphics.cornell.edu/pubs/1995/Arv95c.pdf
+    glm::vec3 sample_spherical_triangle(const glm::vec2& u, const glm::vec3& reference, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2)
+    {
+        const auto a = glm::normalize(v0 - reference);
+        const auto b = glm::normalize(v1 - reference);
+        const auto c = glm::normalize(v2 - reference);
+
+        const auto n_ab = glm::normalize(glm::cross(a, b));
+        const auto n_bc = glm::normalize(glm::cross(b, c));
+        const auto n_ca = glm::normalize(glm::cross(c, a));
+
+        // interior angles at each vertex
+        const auto alpha = angle_between(n_ab, -n_ca);
+        const auto beta = angle_between(n_bc, -n_ab);
+        const auto gamma = angle_between(n_ca, -n_bc);
+
+        // the area of the sub-triangle a b c' grows linearly with u.x, which fixes where c' lies along the arc a c
+        const auto area_pi = glm::mix(glm::pi<Real>(), alpha + beta + gamma, u.x);
+
+        const auto cos_alpha = glm::cos(alpha);
+        const auto sin_alpha = glm::sin(alpha);
+        const auto sin_phi = glm::sin(area_pi) * cos_alpha - glm::cos(area_pi) * sin_alpha;
+        const auto cos_phi = glm::cos(area_pi) * cos_alpha + glm::sin(area_pi) * sin_alpha;
+
+        const auto k1 = cos_phi + cos_alpha;
+        const auto k2 = sin_phi - sin_alpha * glm::dot(a, b);
+        const auto cos_b = glm::clamp((k2 + (k2 * cos_phi - k1 * sin_phi) * cos_alpha) / ((k2 * sin_phi + k1 * cos_phi) * sin_alpha), -1.f, 1.f);
+        const auto sin_b = glm::sqrt(glm::max(0.f, 1.f - cos_b * cos_b));
+
+        const auto c_prime = cos_b * a + sin_b * glm::normalize(orthogonalize(c, a));
+
+        // then u.y moves from b toward c' uniformly in the area that sweeps out
+        const auto cos_theta = 1.f - u.y * (1.f - glm::dot(c_prime, b));
+        const auto sin_theta = glm::sqrt(glm::max(0.f, 1.f - cos_theta * cos_theta));
+        const auto direction = cos_theta * b + sin_theta * glm::normalize(orthogonalize(c_prime, b));
+
+        // where the direction meets the plane of the triangle (Moller-Trumbore)
+        const auto e1 = v1 - v0;
+        const auto e2 = v2 - v0;
+        const auto s1 = glm::cross(direction, e2);
+        const auto divisor = glm::dot(s1, e1);
+
+        if (divisor == 0.f)
+        {
+            return glm::vec3{ 1.f / 3.f };
+        }
+
+        const auto offset = reference - v0;
+        auto b1 = glm::clamp(glm::dot(offset, s1) / divisor, 0.f, 1.f);
+        auto b2 = glm::clamp(glm::dot(direction, glm::cross(offset, e1)) / divisor, 0.f, 1.f);
+
+        if (b1 + b2 > 1.f)
+        {
+            const auto sum = b1 + b2;
+            b1 /= sum;
+            b2 /= sum;
+        }
+
+        return glm::vec3{ 1.f - b1 - b2, b1, b2 };
+    }
 }
 
 namespace ir
 {
-    bool BoundingVolume::contains(const glm::vec3& point) const
+    SurfaceSample Object::sample_from(const glm::vec3& reference, const glm::vec2& u)
     {
-        return (point.x >= origin.x) && (point.x <= origin.x + size.x) &&
-               (point.y >= origin.y) && (point.y <= origin.y + size.y) &&
-               (point.z >= origin.z) && (point.z <= origin.z + size.z);
+        const auto position = sample(u);
+        return SurfaceSample{ position, normal_of(position), pdf_from(reference, position) };
     }
 
-    bool BoundingVolume::intersects(const BoundingVolume& other) const
+    Real Object::pdf_from(const glm::vec3& reference, const glm::vec3& position)
     {
-        return (origin.x <= other.origin.x + other.size.x) && (origin.x + size.x >= other.origin.x) &&
-               (origin.y <= other.origin.y + other.size.y) && (origin.y + size.y >= other.origin.y) &&
-               (origin.z <= other.origin.z + other.size.z) && (origin.z + size.z >= other.origin.z);
+        // area density converted to solid angle; emitters are two-sided so either face counts
+        const auto offset = position - reference;
+        const auto distance2 = glm::dot(offset, offset);
+        const auto cosine = glm::abs(glm::dot(normal_of(position), offset)) / glm::sqrt(distance2);
+
+        if (cosine <= 0.f)
+        {
+            return 0.f;
+        }
+
+        const auto result = pdf(position) * distance2 / cosine;
+        return glm::isinf(result) || glm::isnan(result) ? 0.f : result;
     }
 
-    RayIntersection Sphere::intersect(const Ray& ray)
+    glm::vec3 Sphere::sample(const glm::vec2& u)
     {
-        const auto difference = ray.origin - center;
+        return center + sample_sphere(u, radius);
+    }
 
-        const auto a = glm::dot(ray.direction, ray.direction);
-        const auto b = 2.f * glm::dot(difference, ray.direction);
-        const auto c = glm::dot(difference, difference) - (radius * radius);
-        const auto d = (b * b) - (4.f * a * c);
+    Real Sphere::pdf(const glm::vec3& position)
+    {
+        return 1.f / area;
+    }
 
-        if (d > 0.f)
+    SurfaceSample Sphere::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        const auto offset = center - reference;
+        const auto distance2 = glm::dot(offset, offset);
+
+        if (distance2 <= radius * radius)
         {
-            const auto t1 = (-b - glm::sqrt(d)) / (2.f * a);
-            const auto t2 = (-b + glm::sqrt(d)) / (2.f * a);
+            // every direction sees the sphere from inside, so there is no cone to aim for
+            return Object::sample_from(reference, u);
+        }
 
-            if (t1 > 0.f)
-            {
-                const auto intersection = ray.origin + ray.direction * t1;
+        // uniform over the cone of directions toward the sphere, which only ever reaches its visible cap
+        // https://pbr-book.org/4ed/Shapes/Spheres#Sampling
+        const auto distance = glm::sqrt(distance2);
+        const auto sin2_theta_max = radius * radius / distance2;
+        const auto sin_theta_max = glm::sqrt(sin2_theta_max);
+        const auto cos_theta_max = glm::sqrt(glm::max(0.f, 1.f - sin2_theta_max));
+        auto one_minus_cos_theta_max = 1.f - cos_theta_max;
 
-                const auto reverse = intersection - center;
-                const auto normal = glm::normalize(reverse);
+        auto cos_theta = (cos_theta_max - 1.f) * u.x + 1.f;
+        auto sin2_theta = 1.f - cos_theta * cos_theta;
 
-                // Spherical coordinates https://en.wikipedia.org/wiki/UV_mapping
-                const auto p = glm::normalize(intersection - center);
+        // distant spheres subtend too small a cone for 1 - cos to survive in single floats, so expand it instead
+        if (sin2_theta_max < SMALL_CONE)
+        {
+            sin2_theta = sin2_theta_max * u.x;
+            cos_theta = glm::sqrt(1.f - sin2_theta);
+            one_minus_cos_theta_max = sin2_theta_max / 2.f;
+        }
 
-                const auto u = .5f + glm::atan2(p.z, p.x) / (2.f * glm::pi<Real>());
-                const auto v = .5f + glm::asin(p.y) / glm::pi<Real>();
+        // angle at the center between the reference and the point where the sampled direction meets the sphere
+        const auto cos_alpha = sin2_theta / sin_theta_max + cos_theta * glm::sqrt(glm::max(0.f, 1.f - sin2_theta / sin2_theta_max));
+        const auto sin_alpha = glm::sqrt(glm::max(0.f, 1.f - cos_alpha * cos_alpha));
+        const auto phi = 2.f * glm::pi<Real>() * u.y;
 
-                return
-                {
-                    .position = intersection,
-                    .normal = normal,
-                    .material = material,
-                    .depth = t1,
-                    .exit = t2,
-                    .hit = true,
-                    .object = this,
-                    .uv = { u, v },
-                };
-            }
-        }
+        const auto toward = -offset / distance;
+        const auto tangent = glm::normalize(glm::abs(toward.x) > .9f ? glm::cross(toward, glm::vec3{ 0.f, 1.f, 0.f }) : glm::cross(toward, glm::vec3{ 1.f, 0.f, 0.f }));
+        const auto bitangent = glm::cross(toward, tangent);
+
+        const auto normal = sin_alpha * glm::cos(phi) * tangent + sin_alpha * glm::sin(phi) * bitangent + cos_alpha * toward;
 
-        return MISS;
+        return SurfaceSample{ center + radius * normal, normal, 1.f / (2.f * glm::pi<Real>() * one_minus_cos_theta_max) };
     }
 
-    glm::vec3 Sphere::sample()
+    Real Sphere::pdf_from(const glm::vec3& reference, const glm::vec3& position)
     {
-        return center + glm::sphericalRand(radius);
+        const auto offset = center - reference;
+        const auto distance2 = glm::dot(offset, offset);
+
+        if (distance2 <= radius * radius)
+        {
+            return Object::pdf_from(reference, position);
+        }
+
+        const auto sin2_theta_max = radius * radius / distance2;
+        const auto one_minus_cos_theta_max = sin2_theta_max < SMALL_CONE
+            ? sin2_theta_max / 2.f 
+            : 1.f - glm::sqrt(glm::max(0.f, 1.f - sin2_theta_max));
+
+        return 1.f / (2.f * glm::pi<Real>() * one_minus_cos_theta_max);
     }
 
     glm::vec3 Sphere::normal_of(const glm::vec3& position)
@@ -97,71 +258,59 @@ namespace ir
         return BoundingVolume{ center - glm::vec3{ radius }, glm::vec3{ 2.f * radius } };
     }
 
-    RayIntersection Triangle::intersect(const Ray& ray)
+    PrimitiveType Sphere::type() const
     {
-        // Modified Möller-Trumbore from https://en.m.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+        return PrimitiveType::SPHERE;
+    }
 
-        const auto test = glm::cross(ray.direction, edge1);
+    SpherePrimitive Sphere::compact()
+    {
+        return SpherePrimitive{ center, radius, this };
+    }
 
-        // run Cramer's rule to intersect and get barycentric coordinates as UV
-        const auto determinant = glm::dot(edge0, test);
-        if (glm::abs(determinant) < .001f)
-        {
-            // parallel
-            return MISS;
-        }
+    glm::vec3 Triangle::sample(const glm::vec2& u)
+    {
+        // compute as uniform barycentric coordinates, modified from 
+        // https://stackoverflow.com/questions/4778147/sample-random-point-in-triangle
+        const auto sqrt_r1 = glm::sqrt(u.x);
+        const auto r2 = u.y;
 
-        const auto inverse_determinant = 1.f / determinant;
-        const auto difference = ray.origin - v0;
-        const auto u = glm::dot(difference, test) * inverse_determinant;
+        const auto b1 = 1.f - sqrt_r1;
+        const auto b2 = r2 * sqrt_r1;
 
-        if (u < 0.f || u > 1.f)
-        {
-            // outside
-            return MISS;
-        }
+        return (1.f - b1 - b2) * v0 + b1 * v1 + b2 * v2;
+    }
 
-        const auto q = glm::cross(difference, edge0);
-        const auto v = glm::dot(ray.direction, q) * inverse_determinant;
+    Real Triangle::pdf(const glm::vec3& position)
+    {
+        return 1.f / area;
+    }
 
-        if (v < 0.f || u + v > 1.f)
-        {
-            // outside
-            return MISS;
-        }
+    SurfaceSample Triangle::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        const auto solid_angle = spherical_triangle_area(reference, v0, v1, v2);
 
-        const auto t = glm::dot(edge1, q) * inverse_determinant;
-        if (t <= .001f)
+        if (solid_angle < MINIMUM_SOLID_ANGLE || solid_angle > MAXIMUM_SOLID_ANGLE)
         {
-            // behind
-            return MISS;
+            return Object::sample_from(reference, u);
         }
 
-        const auto intersection = ray.origin + ray.direction * t;
+        const auto barycentric = sample_spherical_triangle(u, reference, v0, v1, v2);
+        const auto position = barycentric.x * v0 + barycentric.y * v1 + barycentric.z * v2;
 
-        return 
-        {
-            .position = intersection,
-            .normal = normal,
-            .material = material,
-            .depth = t,
-            .hit = true,
-            .object = this,
-            .uv = { u, v },
-        };
+        return SurfaceSample{ position, normal, 1.f / solid_angle };
     }
 
-    glm::vec3 Triangle::sample()
+    Real Triangle::pdf_from(const glm::vec3& reference, const glm::vec3& position)
     {
-        // compute as uniform barycentric coordinates, modified from 
-        // https://stackoverflow.com/questions/4778147/sample-random-point-in-triangle
-        const auto sqrt_r1 = glm::sqrt(glm::linearRand(0.f, 1.f));
-        const auto r2 = glm::linearRand(0.f, 1.f);
+        const auto solid_angle = spherical_triangle_area(reference, v0, v1, v2);
 
-        const auto u = 1.f - sqrt_r1;
-        const auto v = r2 * sqrt_r1;
+        if (solid_angle < MINIMUM_SOLID_ANGLE || solid_angle > MAXIMUM_SOLID_ANGLE)
+        {
+            return Object::pdf_from(reference, position);
+        }
 
-        return (1.f - u - v) * v0 + u * v1 + v * v2;
+        return 1.f / solid_angle;
     }
 
     glm::vec3 Triangle::normal_of(const glm::vec3& position)
@@ -178,57 +327,68 @@ namespace ir
         return BoundingVolume{ minimum, maximum - minimum };
     }
 
-    RayIntersection Quadrilateral::intersect(const Ray& ray)
+    PrimitiveType Triangle::type() const
     {
-        // quad intersection from https://raytracing.github.io/books/RayTracingTheNextWeek.html
-        // finds the plane containing the quad, then intersects the plane and verifies quad boundaries
-
-        const auto denominator = glm::dot(normal, ray.direction);
-        if (glm::abs(denominator) < .001f)
-        {
-            // parallel
-            return MISS;
-        }
-
-        const auto t = (constant - glm::dot(normal, ray.origin)) / denominator;
-        if (t <= .001f)
-        {
-            // behind
-            return MISS;
-        }
+        return PrimitiveType::TRIANGLE;
+    }
 
-        const auto intersection = ray.origin + ray.direction * t;
+    glm::vec3 Quadrilateral::sample(const glm::vec2& u)
+    {
+        // simple offsets into the parallelogram
+        return v0 - u.x * v1 - u.y * v2;
+    }
 
-        const auto plane_intersection = intersection - v0;
-        // equivalent to the alpha, beta products in RTTNW quad algorithm
-        const auto u = glm::dot(reciprocal, glm::cross(plane_intersection, v1));
-        const auto v = glm::dot(reciprocal, glm::cross(v2, plane_intersection));
+    Real Quadrilateral::pdf(const glm::vec3& position)
+    {
+        return 1.f / area;
+    }
 
-        if (u < 0.f || u > 1.f || v < 0.f || v > 1.f)
+    SurfaceSample Quadrilateral::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        // the parallelogram seen from reference is two spherical triangles; picking one in proportion to its solid angle
+        // and then sampling it uniformly is uniform over the solid angle of the whole
+        const auto v3 = v0 - v1 - v2;
+        const auto first = spherical_triangle_area(reference, v0, v0 - v1, v3);
+        const auto second = spherical_triangle_area(reference, v0, v3, v0 - v2);
+        const auto solid_angle = first + second;
+
+        if (glm::min(first, second) < MINIMUM_SOLID_ANGLE || solid_angle > MAXIMUM_SOLID_ANGLE)
         {
-            // outside
-            return MISS;
+            return Object::sample_from(reference, u);
         }
 
-        return 
-        {
-            .position = intersection,
-            .normal = normal,
-            .material = material,
-            .depth = t,
-            .hit = true,
-            .object = this,
-            .uv = { u, v },
+        // the fraction of x left over after choosing the triangle is stretched back over [0, 1)
+        const auto split = first / solid_angle;
+        const auto in_first = u.x < split;
+        const auto remapped = glm::vec2
+        { 
+            glm::min(in_first ? u.x / split : (u.x - split) / (1.f - split), 0x1.fffffep-1f), 
+            u.y,
         };
+
+        const auto barycentric = in_first 
+            ? sample_spherical_triangle(remapped, reference, v0, v0 - v1, v3)
+            : sample_spherical_triangle(remapped, reference, v0, v3, v0 - v2);
+        const auto position = in_first
+            ? barycentric.x * v0 + barycentric.y * (v0 - v1) + barycentric.z * v3
+            : barycentric.x * v0 + barycentric.y * v3 + barycentric.z * (v0 - v2);
+
+        return SurfaceSample{ position, normal, 1.f / solid_angle };
     }
 
-    glm::vec3 Quadrilateral::sample()
+    Real Quadrilateral::pdf_from(const glm::vec3& reference, const glm::vec3& position)
     {
-        // simple offsets into the parallelogram
-        const auto u = glm::linearRand(0.f, 1.f);
-        const auto v = glm::linearRand(0.f, 1.f);
+        const auto v3 = v0 - v1 - v2;
+        const auto first = spherical_triangle_area(reference, v0, v0 - v1, v3);
+        const auto second = spherical_triangle_area(reference, v0, v3, v0 - v2);
+        const auto solid_angle = first + second;
 
-        return v0 - u * v1 - v * v2;
+        if (glm::min(first, second) < MINIMUM_SOLID_ANGLE || solid_angle > MAXIMUM_SOLID_ANGLE)
+        {
+            return Object::pdf_from(reference, position);
+        }
+
+        return 1.f / solid_angle;
     }
 
     glm::vec3 Quadrilateral::normal_of(const glm::vec3& position)
@@ -238,333 +398,682 @@ namespace ir
 
     BoundingVolume Quadrilateral::bounds()
     {
-        // check by complete extent
-        const auto minimum = glm::min(v0, glm::min(glm::min(v0 + v1, v0 + v2), v0 + v1 + v2));
-        const auto maximum = glm::max(v0, glm::max(glm::max(v0 + v1, v0 + v2), v0 + v1 + v2));
+        // check by complete extent (edge vectors point back toward the origin corner, see sample())
+        const auto minimum = glm::min(v0, glm::min(glm::min(v0 - v1, v0 - v2), v0 - v1 - v2));
+        const auto maximum = glm::max(v0, glm::max(glm::max(v0 - v1, v0 - v2), v0 - v1 - v2));
 
         return BoundingVolume{ minimum, maximum - minimum };
     }
 
-    RayIntersection Cuboid::intersect(const Ray& ray)
+    PrimitiveType Quadrilateral::type() const
     {
-        // slab method https://en.wikipedia.org/wiki/Slab_method
-        // modified into 3-D from https://www.scratchapixel.com/lessons/3d-basic-rendering/minimal-ray-tracer-rendering-simple-shapes/ray-box-intersection.html
+        return PrimitiveType::QUADRILATERAL;
+    }
 
-        const auto minimum = origin;
-        const auto maximum = origin + size;
+    QuadrilateralPrimitive Quadrilateral::compact()
+    {
+        return QuadrilateralPrimitive{ v0, v1, v2, normal, constant, reciprocal, this };
+    }
 
-        const auto reciprocal = 1.f / ray.direction;
+    glm::vec3 Cuboid::sample(const glm::vec2& u)
+    {
+        // choose a pair of opposite faces in proportion to their area so that points are uniform over the whole surface,
+        // then reuse the fraction of x left over to pick the near or far face and a position across it
+        const auto areas = glm::vec3{ size.y * size.z, size.x * size.z, size.x * size.y };
+        auto scaled = u.x * (areas.x + areas.y + areas.z);
 
-        const auto f1 = (minimum.x - ray.origin.x) * reciprocal.x;
-        const auto f2 = (maximum.x - ray.origin.x) * reciprocal.x;
-        const auto f3 = (minimum.y - ray.origin.y) * reciprocal.y;
-        const auto f4 = (maximum.y - ray.origin.y) * reciprocal.y;
-        const auto f5 = (minimum.z - ray.origin.z) * reciprocal.z;
-        const auto f6 = (maximum.z - ray.origin.z) * reciprocal.z;
+        auto axis = 0;
+        while (axis < 2 && scaled >= areas[axis])
+        {
+            scaled -= areas[axis];
+            axis++;
+        }
 
-        const auto tmin = glm::max(glm::max(glm::min(f1, f2), glm::min(f3, f4)), glm::min(f5, f6));
-        const auto tmax = glm::min(glm::min(glm::max(f1, f2), glm::max(f3, f4)), glm::max(f5, f6));
+        const auto doubled = 2.f * glm::clamp(scaled / areas[axis], 0.f, 1.f);
+        const auto opposite = doubled >= 1.f;
+        const auto s = glm::min(doubled - static_cast<Real>(opposite), 1.f);
+        const auto t = u.y;
 
-        if (tmax < 0.f || tmin > tmax)
+        switch (2 * axis + opposite)
         {
-            return MISS;
+            case 0: return origin + glm::vec3{        0.f, s * size.y, t * size.z };
+            case 1: return origin + glm::vec3{     size.x, s * size.y, t * size.z };
+            case 2: return origin + glm::vec3{ s * size.x,        0.f, t * size.z };
+            case 3: return origin + glm::vec3{ s * size.x,     size.y, t * size.z };
+            case 4: return origin + glm::vec3{ s * size.x, t * size.y,        0.f };
+            case 5: return origin + glm::vec3{ s * size.x, t * size.y,     size.z };
         }
 
-        const auto t1 = tmin >= 0.f ? tmin : tmax;
-        const auto t2 = tmax;
+        return origin;
+    }
 
-        if (t1 > 0.f)
-        {
-            auto intersection = ray.origin + ray.direction * t1;
-            auto normal = normal_of(intersection);
+    Real Cuboid::pdf(const glm::vec3& position)
+    {
+        return 1.f / area;
+    }
 
-            intersection += normal * .001f;
+    glm::vec3 Cuboid::normal_of(const glm::vec3& position)
+    {
+        return ir::normal_of(compact(), position);
+    }
 
-            const auto difference = intersection - centroid;
-            // no idea if this is geometrically correct, but the same formula from the sphere seems to work okay :)
-            const auto u = .5f + glm::atan2(difference.z, difference.x) / (2.f * glm::pi<Real>());
-            const auto v = .5f + glm::asin(difference.y / glm::length(difference)) / glm::pi<Real>();
+    BoundingVolume Cuboid::bounds()
+    {
+        return BoundingVolume{ origin, size };
+    }
 
-            return 
-            {
-                .position = intersection,
-                .normal = normal,
-                .material = material,
-                .depth = t1,
-                .exit = t2,
-                .hit = true,
-                .object = this,
-                .uv = { u, v },
-            };
-        }
+    PrimitiveType Cuboid::type() const
+    {
+        return PrimitiveType::CUBOID;
+    }
 
-        return MISS;
+    CuboidPrimitive Cuboid::compact()
+    {
+        return CuboidPrimitive{ origin, origin + size, this };
     }
 
-    glm::vec3 Cuboid::sample()
+    void Quadric::tabulate()
     {
-        // choose a 2-D point from a random face
-        const auto face = glm::linearRand(0, 6);
-        const auto u = glm::linearRand(0.f, 1.f);
-        const auto v = glm::linearRand(0.f, 1.f);
+        const auto& origin = container.origin;
+        const auto& size = container.size;
 
-        switch (face)
+        patches.clear();
+        patch_cells.clear();
+        patch_cdf.clear();
+        cells.assign(1, 0);
+
+        // every axis in turn, so that each part of the surface is found by the rays it faces most squarely
+        auto total = 0.0;
+        for (auto axis = 0u; axis < 3; axis++)
         {
-            case 0: return origin + glm::vec3{        0.f, u * size.y, v * size.z };
-            case 1: return origin + glm::vec3{     size.x, u * size.y, v * size.z };
-            case 2: return origin + glm::vec3{ u * size.x,        0.f, v * size.z };
-            case 3: return origin + glm::vec3{ u * size.x,     size.y, v * size.z };
-            case 4: return origin + glm::vec3{ u * size.x, v * size.y,        0.f };
-            case 5: return origin + glm::vec3{ u * size.x, v * size.y,     size.z };
+            const auto b = (axis + 1) % 3;
+            const auto c = (axis + 2) % 3;
+            const auto cell_size = glm::vec2{ size[b], size[c] } / static_cast<Real>(RESOLUTION);
+            const auto cell_area = cell_size.x * cell_size.y;
+
+            for (auto i = 0u; i < RESOLUTION; i++)
+            {
+                for (auto j = 0u; j < RESOLUTION; j++)
+                {
+                    auto start = origin;
+                    start[b] += (static_cast<Real>(i) + .5f) * cell_size.x;
+                    start[c] += (static_cast<Real>(j) + .5f) * cell_size.y;
+
+                    auto distances = std::array<Real, 2>{};
+                    const auto count = crossings(start, axis, distances);
+
+                    for (auto k = 0u; k < count; k++)
+                    {
+                        auto position = start;
+                        position[axis] += distances[k];
+
+                        const auto normal = gradient_of(*this, position);
+                        const auto l1 = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+                        if (!(l1 > 0.f) || glm::isinf(l1))
+                        {
+                            continue;
+                        }
+
+                        // a crossing stands for cell_area / |n[axis]| of surface, but is only given the |n[axis]| / |n|_1 share of it
+                        // that this axis is responsible for; the three shares sum to one, and no grazing cosine is ever divided by
+                        const auto weight = cell_area * glm::length(normal) / l1;
+
+                        total += weight;
+                        patches.push_back(position);
+                        patch_cells.push_back(static_cast<std::uint32_t>(cells.size() - 1));
+                        patch_cdf.push_back(static_cast<Real>(total));
+                    }
+
+                    cells.push_back(static_cast<std::uint32_t>(patches.size()));
+                }
+            }
         }
 
-        return origin;
+        area = static_cast<Real>(total);
+
+        for (auto& value : patch_cdf)
+        {
+            value = static_cast<Real>(value / total);
+        }
     }
 
-    glm::vec3 Cuboid::normal_of(const glm::vec3& position)
+    std::uint32_t Quadric::crossings(const glm::vec3& origin, std::uint32_t axis, std::array<Real, 2>& distances) const
     {
-        // compute unit-vector normals depending upon the face (since it is axis-aligned)
+        // f(origin + t axis) = a t^2 + b t + c along a coordinate axis
+        const auto a = std::array<Real, 3>{ A, B, C }[axis];
+        const auto b = gradient_of(*this, origin)[axis];
+        const auto c = evaluate(*this, origin);
 
-        if (glm::abs(position.x - origin.x) < .001f)
+        auto roots = std::array<Real, 2>{};
+        auto count = 0u;
+
+        if (a == 0.f)
         {
-            return glm::vec3{ -1.f, 0.f, 0.f };
+            if (b != 0.f)
+            {
+                roots[count++] = -c / b;
+            }
         }
-        else if (glm::abs(position.x - (origin.x + size.x)) < .001f)
+        else
         {
-            return glm::vec3{ 1.f, 0.f, 0.f };
+            const auto discriminant = b * b - 4.f * a * c;
+            if (discriminant >= 0.f)
+            {
+                // the form that never subtracts nearly equal values https://pbr-book.org/4ed/Shapes/Spheres#IntersectionTests
+                const auto q = -.5f * (b + glm::sign(b + (b == 0.f)) * glm::sqrt(discriminant));
+                roots[count++] = q / a;
+                if (q != 0.f)
+                {
+                    roots[count++] = c / q;
+                }
+            }
         }
-        else if (glm::abs(position.y - origin.y) < .001f)
+
+        if (count == 2 && roots[1] < roots[0])
         {
-            return glm::vec3{ 0.f, -1.f, 0.f };
+            std::swap(roots[0], roots[1]);
         }
-        else if (glm::abs(position.y - (origin.y + size.y)) < .001f)
+
+        auto inside = 0u;
+        for (auto k = 0u; k < count; k++)
         {
-            return glm::vec3{ 0.f, 1.f, 0.f };
+            if (roots[k] >= 0.f && roots[k] <= container.size[axis])
+            {
+                distances[inside++] = roots[k];
+            }
         }
-        else if (glm::abs(position.z - origin.z) < .001f)
+
+        return inside;
+    }
+
+    std::uint32_t Quadric::cell_of(const glm::vec3& position, std::uint32_t axis) const
+    {
+        const auto b = (axis + 1) % 3;
+        const auto c = (axis + 2) % 3;
+        const auto offset = position - container.origin;
+
+        const auto i = glm::clamp(static_cast<std::int32_t>(offset[b] / container.size[b] * RESOLUTION), 0, static_cast<std::int32_t>(RESOLUTION) - 1);
+        const auto j = glm::clamp(static_cast<std::int32_t>(offset[c] / container.size[c] * RESOLUTION), 0, static_cast<std::int32_t>(RESOLUTION) - 1);
+
+        return (axis * RESOLUTION + i) * RESOLUTION + j;
+    }
+
+    // picks a patch by area, then a point across its cell on the same sheet of the surface as the patch, so the work
+    // is bounded however thin the surface is. u.x both picks the patch and, with what is left of it, the point
+    bool Quadric::place(const glm::vec2& u, glm::vec3& position) const
+    {
+        const auto found = std::upper_bound(patch_cdf.begin(), patch_cdf.end(), u.x);
+        const auto index = static_cast<std::uint32_t>(std::min<std::ptrdiff_t>(found - patch_cdf.begin(), patch_cdf.size() - 1));
+
+        const auto lower = index > 0 ? patch_cdf[index - 1] : 0.f;
+        const auto width = patch_cdf[index] - lower;
+        const auto s = width > 0.f ? glm::clamp((u.x - lower) / width, 0.f, 1.f) : .5f;
+
+        const auto cell = patch_cells[index];
+        const auto axis = cell / (RESOLUTION * RESOLUTION);
+        const auto b = (axis + 1) % 3;
+        const auto c = (axis + 2) % 3;
+        const auto i = (cell / RESOLUTION) % RESOLUTION;
+        const auto j = cell % RESOLUTION;
+
+        // the patch itself unless a point across the cell is found
+        position = patches[index];
+
+        auto start = container.origin;
+        start[b] += (static_cast<Real>(i) + s) * container.size[b] / static_cast<Real>(RESOLUTION);
+        start[c] += (static_cast<Real>(j) + u.y) * container.size[c] / static_cast<Real>(RESOLUTION);
+
+        auto distances = std::array<Real, 2>{};
+        const auto count = crossings(start, axis, distances);
+        if (count == 0)
         {
-            return glm::vec3{ 0.f, 0.f, -1.f };
+            // the surface leaves the container or turns away within this cell
+            return false;
         }
-        else if (glm::abs(position.z - (origin.z + size.z)) < .001f)
-        {
-            return glm::vec3{ 0.f, 0.f, 1.f };
-        }  
 
-        return glm::vec3{ 0.f };
+        const auto target = patches[index][axis] - container.origin[axis];
+        const auto nearest = count == 2 && glm::abs(distances[1] - target) < glm::abs(distances[0] - target) ? 1 : 0;
+
+        start[axis] += distances[nearest];
+        position = start;
+
+        return true;
     }
 
-    BoundingVolume Cuboid::bounds()
+    glm::vec3 Quadric::sample(const glm::vec2& u)
     {
-        return BoundingVolume{ origin, size };
+        if (patches.empty())
+        {
+            return centroid;
+        }
+
+        auto position = glm::vec3{};
+        place(u, position);
+
+        return position;
     }
 
-    RayIntersection Quadric::intersect(const Ray& ray)
+    SurfaceSample Quadric::sample_from(const glm::vec3& reference, const glm::vec2& u)
     {
-        const auto& O = ray.origin;
-        const auto& R = ray.direction;
-        const auto& M = centroid;
-
-        const auto a = (A * R.x * R.x) + (B * R.y * R.y) + (C * R.z * R.z) + 
-                       (D * R.x * R.y) + (E * R.x * R.z) + (F * R.y * R.z);
+        auto position = centroid;
+        if (patches.empty() || !place(u, position))
+        {
+            // no density to weigh the point by, so the sample is spent without bias rather than counted at the patch
+            return SurfaceSample{ position, normal_of(position), 0.f };
+        }
 
-        const auto b = (2.f * A * (O.x - M.x) * R.x) + (2.f * B * (O.y - M.y) * R.y) + (2.f * C * (O.z - M.z) * R.z) + 
-                       (D * ((O.x - M.x) * R.y + (O.y - M.y) * R.x)) + 
-                       (E * ((O.x - M.x) * R.z + (O.z - M.z) * R.x)) + 
-                       (F * ((O.y - M.y) * R.z + (O.z - M.z) * R.y)) +
-                       (G * R.x + H * R.y + I * R.z);
+        return SurfaceSample{ position, normal_of(position), pdf_from(reference, position) };
+    }
 
-        const auto c = (A * (O.x - M.x) * (O.x - M.x)) + (B * (O.y - M.y) * (O.y - M.y)) + (C * (O.z - M.z) * (O.z - M.z)) + 
-                       (D * (O.x - M.x) * (O.y - M.y)) +
-                       (E * (O.x - M.x) * (O.z - M.z)) +
-                       (F * (O.y - M.y) * (O.z - M.z)) +
-                       (G * (O.x - M.x) + H * (O.y - M.y) + I * (O.z - M.z)) + J;
+    Real Quadric::pdf(const glm::vec3& position)
+    {
+        if (patches.empty())
+        {
+            return 0.f;
+        }
 
-        const auto d = (b * b) - (4.f * a * c);
+        const auto normal = glm::normalize(gradient_of(*this, position));
 
-        if (d > 0.f)
+        // sample() reaches position through any patch of the cell around it, along any axis, whose sheet it lies on
+        auto density = 0.f;
+        for (auto axis = 0u; axis < 3; axis++)
         {
-            const auto t1 = (-b - glm::sqrt(d)) / (2.f * a);
-            const auto t2 = (-b + glm::sqrt(d)) / (2.f * a);
+            auto start = position;
+            start[axis] = container.origin[axis];
 
-            if (t1 > 0.f)
+            auto distances = std::array<Real, 2>{};
+            const auto count = crossings(start, axis, distances);
+            if (count == 0)
             {
-                const auto intersection = ray.origin + ray.direction * t1;
-                auto normal = normal_of(intersection);
+                continue;
+            }
 
-                // effectively clamp the quadric surface to the corresponding clip cube
-                if (glm::any(glm::lessThan(intersection, container->origin)) || 
-                    glm::any(glm::greaterThan(intersection, container->origin + container->size)))
-                {
-                    return MISS;
-                }
+            const auto b = (axis + 1) % 3;
+            const auto c = (axis + 2) % 3;
+            const auto cell_area = container.size[b] * container.size[c] / static_cast<Real>(RESOLUTION * RESOLUTION);
+            const auto tolerance = QUADRIC_TOLERANCE * container.size[axis];
+            const auto depth = position[axis] - container.origin[axis];
 
-                const auto difference = intersection - container->centroid;
-                // no idea if this is geometrically correct, but the same formula from the sphere seems to work okay :)
-                const auto u = .5f + glm::atan2(difference.z, difference.x) / (2.f * glm::pi<Real>());
-                const auto v = .5f + glm::asin(difference.y / glm::length(difference)) / glm::pi<Real>();
+            const auto cell = cell_of(position, axis);
+            for (auto index = cells[cell]; index < cells[cell + 1]; index++)
+            {
+                const auto target = patches[index][axis] - container.origin[axis];
+                const auto nearest = count == 2 && glm::abs(distances[1] - target) < glm::abs(distances[0] - target) ? 1 : 0;
 
-                return 
+                if (glm::abs(distances[nearest] - depth) > tolerance)
                 {
-                    .position = intersection,
-                    .normal = normal,
-                    .material = material,
-                    .depth = t1,
-                    .exit = t2,
-                    .hit = true,
-                    .object = this,
-                    .uv = { u, v },
-                };
+                    continue;
+                }
+
+                // uniform across the cell, which the surface stretches by 1 / |n[axis]|
+                const auto probability = patch_cdf[index] - (index > 0 ? patch_cdf[index - 1] : 0.f);
+                density += probability * glm::abs(normal[axis]) / cell_area;
             }
         }
 
-        return MISS;
+        return glm::isnan(density) ? 0.f : density;
     }
 
-    // TODO: proper sampling instead of random chance
-    glm::vec3 Quadric::sample()
+    glm::vec3 Quadric::normal_of(const glm::vec3& position)
     {
-        auto point = glm::vec3{};
-        do
-        {
-            point = glm::linearRand(container->origin, container->origin + container->size);
-        } 
-        while (glm::abs(function(point)) > .001f);
+        return ir::normal_of(compact(), position);
+    }
 
-        return point;
+    BoundingVolume Quadric::bounds()
+    {
+        return container.bounds();
     }
 
-    glm::vec3 Quadric::normal_of(const glm::vec3& position)
+    PrimitiveType Quadric::type() const
+    {
+        return PrimitiveType::QUADRIC;
+    }
+
+    QuadricPrimitive Quadric::compact()
     {
-        // derivatives of the quadric function
-        // d/dx = 2Ax + Dy + Ez + G = 0
-        // d/dy = 2By + Dx + Fz + H = 0
-        // d/dz = 2Cz + Ex + Fy + I = 0
+        return QuadricPrimitive{ { A, B, C, D, E, F, G, H, I, J }, centroid, container.origin, container.origin + container.size, this };
+    }
 
-        return glm::normalize(glm::vec3
-        {
-            2.f * A * (position.x - centroid.x) + D * (position.y - centroid.y) + E * (position.z - centroid.z) + G,
-            2.f * B * (position.y - centroid.y) + D * (position.x - centroid.x) + F * (position.z - centroid.z) + H,
-            2.f * C * (position.z - centroid.z) + E * (position.x - centroid.x) + F * (position.y - centroid.y) + I,
-        });
+    glm::vec3 Colloid::sample(const glm::vec2& u)
+    {
+        return container->sample(u);
     }
 
-    BoundingVolume Quadric::bounds()
+    Real Colloid::pdf(const glm::vec3& position)
+    {
+        return container->pdf(position);
+    }
+
+    SurfaceSample Colloid::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        return container->sample_from(reference, u);
+    }
+
+    Real Colloid::pdf_from(const glm::vec3& reference, const glm::vec3& position)
+    {
+        return container->pdf_from(reference, position);
+    }
+
+    glm::vec3 Colloid::normal_of(const glm::vec3& position)
+    {
+        return rng().sphere(1.f);
+    }
+
+    BoundingVolume Colloid::bounds()
     {
         return container->bounds();
     }
 
-    RayIntersection Colloid::intersect(const Ray& ray)
+    PrimitiveType Colloid::type() const
     {
-        const auto intersection = container->intersect(ray);
-        if (!intersection.hit)
+        return PrimitiveType::COLLOID;
+    }
+
+    glm::vec3 Volume::sample(const glm::vec2& u)
+    {
+        return container->sample(u);
+    }
+
+    Real Volume::pdf(const glm::vec3& position)
+    {
+        return container->pdf(position);
+    }
+
+    SurfaceSample Volume::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        return container->sample_from(reference, u);
+    }
+
+    Real Volume::pdf_from(const glm::vec3& reference, const glm::vec3& position)
+    {
+        return container->pdf_from(reference, position);
+    }
+
+    glm::vec3 Volume::normal_of(const glm::vec3& position)
+    {
+        return rng().sphere(1.f);
+    }
+
+    BoundingVolume Volume::bounds()
+    {
+        return container->bounds();
+    }
+
+    PrimitiveType Volume::type() const
+    {
+        return PrimitiveType::VOLUME;
+    }
+
+    void Mesh::build()
+    {
+        std::erase(objects, nullptr);
+
+        // authoring triangles join the indexed faces up front so that every triangle shares one representation
+        auto others = std::vector<Object*>{};
+        for (const auto object : objects)
+        {
+            if (object->type() == PrimitiveType::TRIANGLE)
+            {
+                store.add(object);
+            }
+            else
+            {
+                others.push_back(object);
+            }
+        }
+
+        // hierarchy primitives are numbered faces first, followed by the remaining authoring objects
+        const auto face_count = static_cast<std::uint32_t>(store.triangles.size());
+        const auto type_of = [&](std::uint32_t index)
+        {
+            return index < face_count ? PrimitiveType::TRIANGLE : others[index - face_count]->type();
+        };
+
+        auto volumes = std::vector<BoundingVolume>{};
+        auto centroids = std::vector<glm::vec3>{};
+        volumes.reserve(face_count + others.size());
+        centroids.reserve(face_count + others.size());
+
+        for (auto face = 0u; face < face_count; face++)
         {
-            return MISS;
+            volumes.emplace_back(store.triangles.bounds(face));
+            centroids.emplace_back(store.triangles.centroid(face));
         }
 
-        const auto entry = ray.origin + ray.direction * intersection.depth;
-        const auto exit = ray.origin + ray.direction * intersection.exit;
-        const auto scatter_distance = glm::length(exit - entry);
-        if (scatter_distance <= 0.f)
+        for (const auto object : others)
         {
-            return MISS;
+            volumes.emplace_back(object->bounds());
+            centroids.emplace_back(object->centroid);
         }
-        
-        // exponential falloff per https://raytracing.github.io/books/RayTracingTheNextWeek.html#volumes/constantdensitymediums
-        const auto random = glm::linearRand(0.f, 1.f);
-        const auto travel = -(1.f / density) * glm::log(random);
 
-        if (travel < scatter_distance)
+        hierarchy.build(volumes, centroids, TrianglePacket::WIDTH);
+
+        primitives.resize(hierarchy.indices.size());
+        auto packet_count = 0uz;
+
+        for (const auto& leaf : hierarchy.nodes)
         {
-            // scatter randomly within the bounding media
-            const auto position = entry + ray.direction * travel;
-            const auto normal = glm::sphericalRand(1.f);
+            if (leaf.count == 0)
+            {
+                continue;
+            }
 
-            const auto attenuation = glm::exp(-density * travel * material.albedo);
-            material.albedo *= attenuation;
+            // group the leaf by type so that its triangles form a contiguous prefix for the packet
+            // and the remaining primitives dispatch over homogeneous runs
+            const auto begin = hierarchy.indices.begin() + leaf.first;
+            const auto end = begin + leaf.count;
+            std::stable_sort(begin, end, [&](std::uint32_t a, std::uint32_t b)
+            {
+                return type_of(a) < type_of(b);
+            });
 
-            return 
+            // compiling in leaf order keeps each leaf's primitives adjacent within their per-type arrays
+            for (auto i = leaf.first; i < leaf.first + leaf.count; i++)
             {
-                .position = position,
-                .normal = normal,
-                .material = material,
-                .depth = glm::length(position - ray.origin),
-                .hit = true,
-                .object = this,
-                .uv = { 0.f, 0.f },
-            };
+                const auto index = hierarchy.indices[i];
+                primitives[i] = index < face_count ? PrimitiveReference{ PrimitiveType::TRIANGLE, index } : store.add(others[index - face_count]);
+            }
+
+            packet_count += (type_of(*begin) == PrimitiveType::TRIANGLE);
         }
 
-        return MISS;
-    }
+        media = !store.colloids.empty() || !store.volumes.empty();
 
-    glm::vec3 Colloid::sample()
-    {
-        return container->sample();
+        packets.clear();
+        leaf_packets.assign(hierarchy.nodes.size(), NO_PACKET);
+
+        if (packet_count * sizeof(TrianglePacket) > PACKET_BUDGET)
+        {
+            return;
+        }
+
+        packets.reserve(packet_count);
+
+        for (auto node = 0uz; node < hierarchy.nodes.size(); node++)
+        {
+            const auto& leaf = hierarchy.nodes[node];
+            if (leaf.count == 0 || primitives[leaf.first].type() != PrimitiveType::TRIANGLE)
+            {
+                continue;
+            }
+
+            // any triangles beyond the packet width (only possible in depth-limited leaves) stay on the indexed path
+            auto packet = TrianglePacket{};
+            for (auto lane = 0u; lane < TrianglePacket::WIDTH && lane < leaf.count && primitives[leaf.first + lane].type() == PrimitiveType::TRIANGLE; lane++)
+            {
+                const auto face = primitives[leaf.first + lane].index;
+                const auto& v0 = store.triangles.position(face, 0);
+                packet.set(lane, v0, store.triangles.position(face, 1) - v0, store.triangles.position(face, 2) - v0, face);
+            }
+
+            leaf_packets[node] = static_cast<std::uint32_t>(packets.size());
+            packets.push_back(packet);
+        }
     }
 
-    glm::vec3 Colloid::normal_of(const glm::vec3& position)
+    RayIntersection Mesh::resolve(const Hit& hit, const Ray& ray, const MaterialTable& materials) const
     {
-        return glm::sphericalRand(1.f);
+        return ir::resolve(store, materials, hit, ray);
     }
 
-    BoundingVolume Colloid::bounds()
+    Ray MeshInstance::localize(const Ray& ray) const
     {
-        return container->bounds();
+        // NOTE: the local direction is deliberately left unnormalized. An affine map preserves the ray parameter,
+        // so local depth and exit are already the world-space depth and exit and need no rescaling afterward
+        return Ray
+        {
+            .origin = glm::vec3{ inverse * glm::vec4{ ray.origin, 1.f } },
+            // IMPORTANT: DO NOT CHANGE W=0, OTHERWISE THE TRANSLATION GETS APPLIED AGAIN WITH BAD RESULTS!!!!
+            .direction = glm::vec3{ inverse * glm::vec4{ ray.direction, 0.f } },
+        };
     }
 
-    RayIntersection MeshInstance::intersect(const Ray& ray) const
+    bool MeshInstance::intersect(const Ray& ray, Real t_max, Hit& hit) const
     {
-        auto nearest_intersection = RayIntersection{}, furthest_intersection = RayIntersection{};
+        // transform ray into the mesh's local space once for the whole query
+        const auto ray_transformed = localize(ray);
 
-        auto is_composite_mesh = false;
+        auto nearest_hit = Hit{ .depth = t_max };
 
-        for (const auto& object : mesh)
+        mesh.hierarchy.traverse_leaves(ray_transformed, nearest_hit.depth, [&](std::uint32_t node)
         {
-            if (!object)
+            const auto& leaf = mesh.hierarchy.nodes[node];
+            auto first = leaf.first;
+
+            if (const auto packet = mesh.leaf_packets[node]; packet != Mesh::NO_PACKET)
             {
-                continue;
+                auto packet_hit = PacketHit{};
+                if (ir::intersect(mesh.packets[packet], ray_transformed, nearest_hit.depth, packet_hit))
+                {
+                    nearest_hit = Hit
+                    {
+                        .depth = packet_hit.depth,
+                        .primitive = PrimitiveReference{ PrimitiveType::TRIANGLE, packet_hit.primitive },
+                        .barycentric = packet_hit.barycentric,
+                    };
+                }
+
+                first += mesh.packets[packet].size();
             }
 
-            // transform ray into object's local space
-            const auto ray_transformed = Ray
+            for (auto i = first; i < leaf.first + leaf.count; i++)
             {
-                .origin = glm::vec3{ inverse * glm::vec4{ ray.origin, 1.f } },
-                // IMPORTANT: DO NOT CHANGE W=0, OTHERWISE THE TRANSLATION GETS APPLIED AGAIN WITH BAD RESULTS!!!!
-                .direction = glm::vec3{ inverse * glm::vec4{ ray.direction, 0.f } },
-            };
+                auto candidate = Hit{};
+                if (ir::intersect(mesh.store, mesh.primitives[i], ray_transformed, nearest_hit.depth, candidate))
+                {
+                    candidate.primitive = mesh.primitives[i];
+                    nearest_hit = candidate;
+                }
+            }
 
-            auto intersection = object->intersect(ray_transformed);
-            if (intersection.hit)
-            {
-                // transform relevant intersection space (object local coordinates) back into world space
+            return false;
+        });
 
-                intersection.position = glm::vec3{ transform * glm::vec4{ intersection.position, 1.f } };
-                // IMPORTANT: DO NOT CHANGE W=0, OTHERWISE THE TRANSLATION GETS APPLIED AGAIN WITH BAD RESULTS!!!!
-                intersection.normal = glm::normalize(glm::vec3{ transform * glm::vec4{ intersection.normal, 0.f } });
+        if (nearest_hit.depth < t_max)
+        {
+            hit = nearest_hit;
+            return true;
+        }
 
-                // TODO: ask Shaeffer why these are not required (produce shadow artifacts)
-                // const auto entry_position = intersection.position;
-                // const auto exit_position = intersection.position + ray_transformed.direction * (intersection.exit - intersection.depth);
-                // intersection.depth = glm::length(glm::vec3{ instance.transform * glm::vec4{ entry_position, 1.f } } - ray.origin);
-                // intersection.exit = glm::length(glm::vec3{ instance.transform * glm::vec4{ exit_position, 1.f } } - ray.origin);
+        return false;
+    }
+
+    RayIntersection MeshInstance::resolve(const Ray& ray, const Hit& hit, const MaterialTable& materials) const
+    {
+        auto intersection = mesh.resolve(hit, localize(ray), materials);
+
+        if (material != NO_MATERIAL)
+        {
+            intersection.material = &materials[material];
+        }
 
-                if (intersection.depth < nearest_intersection.depth)
+        // transform only the final intersection (object local coordinates) back into world space
+        intersection.position = glm::vec3{ transform * glm::vec4{ intersection.position, 1.f } };
+        // normals transform by the inverse transpose so they stay perpendicular under non-uniform scale
+        intersection.normal = glm::normalize(normal_matrix * intersection.normal);
+
+        return intersection;
+    }
+
+    bool MeshInstance::occluded(const Ray& ray, Real t_max) const
+    {
+        const auto ray_transformed = localize(ray);
+
+        auto occluded = false;
+
+        // any blocker in front of t_max suffices, so stop at the first one regardless of order
+        mesh.hierarchy.traverse_leaves(ray_transformed, t_max, [&](std::uint32_t node)
+        {
+            const auto& leaf = mesh.hierarchy.nodes[node];
+            auto first = leaf.first;
+
+            if (const auto packet = mesh.leaf_packets[node]; packet != Mesh::NO_PACKET)
+            {
+                auto packet_hit = PacketHit{};
+                occluded = ir::intersect(mesh.packets[packet], ray_transformed, t_max, packet_hit);
+                if (occluded)
                 {
-                    nearest_intersection = intersection;
+                    return true;
                 }
-                else if (intersection.exit > furthest_intersection.exit)
+
+                first += mesh.packets[packet].size();
+            }
+
+            for (auto i = first; i < leaf.first + leaf.count; i++)
+            {
+                auto hit = Hit{};
+                occluded = ir::intersect(mesh.store, mesh.primitives[i], ray_transformed, t_max, hit);
+                if (occluded)
                 {
-                    furthest_intersection = intersection;
+                    return true;
                 }
             }
-        }
 
-        if (nearest_intersection.hit && furthest_intersection.hit && nearest_intersection.exit == std::numeric_limits<float>::infinity())
+            return false;
+        });
+
+        return occluded;
+    }
+
+    Real MeshInstance::transmittance(const Ray& ray, Real t_max) const
+    {
+        // without media every primitive blocks outright, which the any-hit test answers from the first blocker
+        if (!mesh.media)
         {
-            nearest_intersection.exit = furthest_intersection.exit;
+            return occluded(ray, t_max) ? 0.f : 1.f;
         }
 
-        return nearest_intersection;
+        const auto ray_transformed = localize(ray);
+
+        auto transmittance = 1.f;
+
+        // unlike occluded(), media only dim the ray, so every leaf in front of t_max is visited until something opaque
+        mesh.hierarchy.traverse_leaves(ray_transformed, t_max, [&](std::uint32_t node)
+        {
+            const auto& leaf = mesh.hierarchy.nodes[node];
+            auto first = leaf.first;
+
+            if (const auto packet = mesh.leaf_packets[node]; packet != Mesh::NO_PACKET)
+            {
+                auto packet_hit = PacketHit{};
+                if (ir::intersect(mesh.packets[packet], ray_transformed, t_max, packet_hit))
+                {
+                    transmittance = 0.f;
+                    return true;
+                }
+
+                first += mesh.packets[packet].size();
+            }
+
+            for (auto i = first; i < leaf.first + leaf.count && transmittance > 0.f; i++)
+            {
+                transmittance *= ir::transmittance(mesh.store, mesh.primitives[i], ray_transformed, t_max);
+            }
+
+            return transmittance <= 0.f;
+        });
+
+        return transmittance;
     }
 
     BoundingVolume MeshInstance::bounds() const
@@ -572,31 +1081,312 @@ namespace ir
         return volume;
     }
 
+    MaterialId MeshInstance::material_of(const Object& object) const
+    {
+        return material != NO_MATERIAL ? material : object.material;
+    }
+
+    InstancedObject::InstancedObject(Object* object, const MeshInstance& instance)
+        : Object{ object->material }, object{ object }, transform{ instance.transform }, inverse{ instance.inverse },
+          normal_matrix{ instance.normal_matrix }, determinant{ glm::abs(glm::determinant(glm::mat3{ instance.transform })) }
+    {
+        centroid = globalize(object->centroid);
+
+        // the stretch varies across curved surfaces under non-uniform scale, so it is averaged over stratified samples
+        auto total = 0.f;
+        for (auto i = 0u; i < AREA_SAMPLES; i++)
+        {
+            for (auto j = 0u; j < AREA_SAMPLES; j++)
+            {
+                const auto u = (glm::vec2{ static_cast<Real>(i), static_cast<Real>(j) } + .5f) / static_cast<Real>(AREA_SAMPLES);
+                total += stretch(object->sample(u));
+            }
+        }
+
+        area = object->area * total / static_cast<Real>(AREA_SAMPLES * AREA_SAMPLES);
+    }
+
+    glm::vec3 InstancedObject::localize(const glm::vec3& position) const
+    {
+        return glm::vec3{ inverse * glm::vec4{ position, 1.f } };
+    }
+
+    glm::vec3 InstancedObject::globalize(const glm::vec3& position) const
+    {
+        return glm::vec3{ transform * glm::vec4{ position, 1.f } };
+    }
+
+    Real InstancedObject::stretch(const glm::vec3& position) const
+    {
+        return determinant * glm::length(normal_matrix * glm::normalize(object->normal_of(position)));
+    }
+
+    PrimitiveType InstancedObject::type() const
+    {
+        return object->type();
+    }
+
+    glm::vec3 InstancedObject::sample(const glm::vec2& u)
+    {
+        return globalize(object->sample(u));
+    }
+
+    Real InstancedObject::pdf(const glm::vec3& position)
+    {
+        const auto local = localize(position);
+        return object->pdf(local) / stretch(local);
+    }
+
+    SurfaceSample InstancedObject::sample_from(const glm::vec3& reference, const glm::vec2& u)
+    {
+        const auto local = object->sample_from(localize(reference), u);
+        if (local.pdf <= 0.f)
+        {
+            return SurfaceSample{};
+        }
+
+        const auto position = globalize(local.position);
+        return SurfaceSample{ position, normal_of(position), pdf_from(reference, position) };
+    }
+
+    Real InstancedObject::pdf_from(const glm::vec3& reference, const glm::vec3& position)
+    {
+        // solid angle is not preserved by the transform, but area is up to the stretch, so the local density goes
+        // through area on its way to world-space solid angle
+        const auto local_reference = localize(reference);
+        const auto local_position = localize(position);
+
+        const auto cosine_over_distance2 = [](const glm::vec3& normal, const glm::vec3& offset)
+        {
+            const auto distance2 = glm::dot(offset, offset);
+            return glm::abs(glm::dot(normal, offset)) / (glm::sqrt(distance2) * distance2);
+        };
+
+        const auto local_normal = glm::normalize(object->normal_of(local_position));
+        const auto local_area_pdf = object->pdf_from(local_reference, local_position) * cosine_over_distance2(local_normal, local_position - local_reference);
+
+        const auto result = local_area_pdf / (stretch(local_position) * cosine_over_distance2(normal_of(position), position - reference));
+        return glm::isinf(result) || glm::isnan(result) ? 0.f : result;
+    }
+
+    glm::vec3 InstancedObject::normal_of(const glm::vec3& position)
+    {
+        return glm::normalize(normal_matrix * object->normal_of(localize(position)));
+    }
+
+    BoundingVolume InstancedObject::bounds()
+    {
+        const auto local = object->bounds();
+
+        auto minimum = glm::vec3{ std::numeric_limits<Real>::max() };
+        auto maximum = glm::vec3{ -std::numeric_limits<Real>::max() };
+
+        for (auto corner = 0; corner < 8; corner++)
+        {
+            const auto world = globalize(local.origin + local.size * glm::vec3{ corner & 1, (corner >> 1) & 1, (corner >> 2) & 1 });
+            minimum = glm::min(minimum, world);
+            maximum = glm::max(maximum, world);
+        }
+
+        return BoundingVolume{ minimum, maximum - minimum };
+    }
+
+    void Scene::build()
+    {
+        auto volumes = std::vector<BoundingVolume>{};
+        auto centroids = std::vector<glm::vec3>{};
+        volumes.reserve(instances.size());
+        centroids.reserve(instances.size());
+
+        media = false;
+
+        for (const auto& instance : instances)
+        {
+            const auto volume = instance.bounds();
+            volumes.emplace_back(volume);
+            centroids.emplace_back(volume.origin + volume.size / 2.f);
+            media |= instance.mesh.media;
+        }
+
+        hierarchy.build(volumes, centroids);
+    }
+
+    void Scene::clear()
+    {
+        // instances refer to meshes in the arena, so they must go first
+        instances.clear();
+        hierarchy = BoundingVolumeHierarchy{};
+        media = false;
+        arena.clear();
+        materials.clear();
+    }
+
+    RayIntersection Scene::intersect(const Ray& ray) const
+    {
+        auto nearest_hit = Hit{};
+        auto nearest_instance = std::numeric_limits<std::uint32_t>::max();
+
+        const auto reciprocal = 1.f / ray.direction;
+
+        hierarchy.traverse(ray, nearest_hit.depth, [&](std::uint32_t index)
+        {
+            const auto& instance = instances[index];
+            const auto volume = instance.bounds();
+
+            // leaves may hold several instances, so only pay for the transform into instance space once its own box is hit
+            if (intersect_box(volume.origin, volume.origin + volume.size, ray.origin, reciprocal, nearest_hit.depth) == std::numeric_limits<Real>::infinity())
+            {
+                return false;
+            }
+
+            if (instance.intersect(ray, nearest_hit.depth, nearest_hit))
+            {
+                nearest_instance = index;
+            }
+
+            return false;
+        });
+
+        if (nearest_instance == std::numeric_limits<std::uint32_t>::max())
+        {
+            return RayIntersection{};
+        }
+
+        // only the winning hit across all instances has its surface evaluated
+        auto intersection = instances[nearest_instance].resolve(ray, nearest_hit, materials);
+        intersection.instance = nearest_instance;
+
+        return intersection;
+    }
+
+    bool Scene::occluded(const Ray& ray, Real t_max) const
+    {
+        const auto reciprocal = 1.f / ray.direction;
+
+        auto occluded = false;
+
+        hierarchy.traverse(ray, t_max, [&](std::uint32_t index)
+        {
+            const auto& instance = instances[index];
+            const auto volume = instance.bounds();
+
+            if (intersect_box(volume.origin, volume.origin + volume.size, ray.origin, reciprocal, t_max) == std::numeric_limits<Real>::infinity())
+            {
+                return false;
+            }
+
+            occluded = instance.occluded(ray, t_max);
+            return occluded;
+        });
+
+        return occluded;
+    }
+
+    Real Scene::transmittance(const Ray& ray, Real t_max) const
+    {
+        const auto reciprocal = 1.f / ray.direction;
+
+        auto transmittance = 1.f;
+
+        hierarchy.traverse(ray, t_max, [&](std::uint32_t index)
+        {
+            const auto& instance = instances[index];
+            const auto volume = instance.bounds();
+
+            if (intersect_box(volume.origin, volume.origin + volume.size, ray.origin, reciprocal, t_max) == std::numeric_limits<Real>::infinity())
+            {
+                return false;
+            }
+
+            transmittance *= instance.transmittance(ray, t_max);
+            return transmittance <= 0.f;
+        });
+
+        return transmittance;
+    }
+
     // (c) Connor J. Link. Partial attribution (meaningful modifications performed herein) from personal work outside of ISU.
     // Utility function that does not meaningfully affect project functionality.
-    Mesh load_obj(const std::string& filepath, const PBRMaterial& default_material)
+    Mesh load_obj(const std::string& filepath, MaterialId material)
     {
-        Mesh objects{};
-
         std::ifstream file(filepath);
         if (!file.good())
         {
-            return objects;
+            return Mesh{};
         }
 
-        std::vector<glm::vec3> vertices{};
+        auto triangles = IndexedTriangles{};
+
+        std::vector<glm::vec3> positions{};
+        std::vector<glm::vec2> uvs{};
+        std::vector<glm::vec3> normals{};
+
+        // OBJ indexes positions, texture coordinates and normals separately, so each distinct combination
+        // of the three becomes one shared vertex of the index buffer
+        std::map<std::array<int, 3>, std::uint32_t> vertices{};
+        // absolute position, UV and normal index of each shared vertex, 0 meaning an absent attribute. the vertex
+        // buffers are only filled in once the whole file is read, as a UV or normal may first appear after faces
+        // that had none, and every vertex needs an entry once any one of them does
+        std::vector<std::array<int, 3>> keys{};
+
+        auto number = 0uz;
+        const auto fail = [&](const std::string& reason)
+        {
+            throw std::runtime_error(filepath + ":" + std::to_string(number) + ": " + reason);
+        };
+
+        // resolves one "v", "v/vt", "v//vn" or "v/vt/vn" face corner into a shared vertex
+        const auto vertex_of = [&](const std::string& corner)
+        {
+            auto key = std::array<int, 3>{ 0, 0, 0 };
+            const auto counts = std::array<std::size_t, 3>{ positions.size(), uvs.size(), normals.size() };
+
+            auto attribute = 0uz;
+            for (const auto& field : split(corner, "/"))
+            {
+                if (attribute < 3 && !field.empty())
+                {
+                    const auto index = std::stoi(field);
+                    // negative indices count back from the most recently declared element
+                    key[attribute] = index < 0 ? static_cast<int>(counts[attribute]) + index + 1 : index;
+
+                    if (key[attribute] <= 0 || static_cast<std::size_t>(key[attribute]) > counts[attribute])
+                    {
+                        fail("face corner " + corner + " refers to an element that has not been declared");
+                    }
+                }
+                attribute++;
+            }
+
+            if (key[0] == 0)
+            {
+                fail("face corner " + corner + " has no position");
+            }
+
+            if (const auto it = vertices.find(key); it != vertices.end())
+            {
+                return it->second;
+            }
+
+            const auto vertex = static_cast<std::uint32_t>(keys.size());
+            keys.push_back(key);
+
+            vertices.emplace(key, vertex);
+            return vertex;
+        };
 
         std::string line;
         while (std::getline(file, line))
         {
+            number++;
+
             auto tokens = split(line, " ");
+            std::erase(tokens, "");
             if (tokens.empty()) 
             {
                 continue;
             }
 
-            // TODO: incorporate normals and normal smoothing as necessary
-            // TODO: incorporate texture coordinates as necessary
             // TODO: incorporate material files as necessary
 
             if (tokens[0] == "v" && tokens.size() >= 4)
@@ -605,49 +1395,59 @@ namespace ir
                 const auto y = std::stof(tokens[2]);
                 const auto z = std::stof(tokens[3]);
 
-                vertices.emplace_back(x, y, z);
+                positions.emplace_back(x, y, z);
+            }
+            else if (tokens[0] == "vt" && tokens.size() >= 3)
+            {
+                uvs.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]));
+            }
+            else if (tokens[0] == "vn" && tokens.size() >= 4)
+            {
+                normals.emplace_back(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
             }
             else if (tokens[0] == "f" && tokens.size() >= 4)
             {
-                if (tokens.size() == 4)
-                {
-                    // triangle, 3 vertices to form the face
-                    const auto face0 = std::stoi(tokens[1]);
-                    const auto face1 = std::stoi(tokens[2]);
-                    const auto face2 = std::stoi(tokens[3]);
-
-                    objects.emplace_back(new Triangle
-                    { 
-                        vertices[face0 - 1], 
-                        vertices[face1 - 1], 
-                        vertices[face2 - 1], 
-                        glm::vec2{ 0.f, 0.f }, 
-                        glm::vec2{ 0.f, 1.f }, 
-                        glm::vec2{ 1.f, 1.f }, 
-                        default_material,
-                    });
-                }
-                else if (tokens.size() == 5)
+                // OBJ format note: consecutive vertices connected in polygon specification per https://en.wikipedia.org/wiki/Wavefront_.obj_file
+                // so triangles, quadrilaterals and any larger convex polygons are split into a fan about the first vertex
+                const auto first = vertex_of(tokens[1]);
+                auto previous = vertex_of(tokens[2]);
+
+                for (auto i = 3uz; i < tokens.size(); i++)
                 {
-                    // quadrilateral, 4 vertices to form the face
-                    const auto face0 = std::stoi(tokens[1]);
-                    const auto face1 = std::stoi(tokens[2]);
-                    [[maybe_unused]] const auto face2 = std::stoi(tokens[3]);
-                    const auto face3 = std::stoi(tokens[4]);
-
-                    // OBJ format note: consecutive vertices connected in polygon specification per https://en.wikipedia.org/wiki/Wavefront_.obj_file
-                    objects.emplace_back(new Quadrilateral
-                    {
-                        vertices[face0 - 1],
-                        vertices[face1 - 1],
-                        vertices[face3 - 1],
-                        default_material,
-                    });
+                    const auto current = vertex_of(tokens[i]);
+
+                    triangles.indices.insert(triangles.indices.end(), { first, previous, current });
+                    triangles.face_materials.push_back(material);
+                    triangles.face_objects.push_back(nullptr);
+
+                    previous = current;
                 }
-                
             }
         }
 
-        return objects;
+        const auto has = [&](std::size_t attribute)
+        {
+            return std::ranges::any_of(keys, [&](const auto& key) { return key[attribute] > 0; });
+        };
+        const auto has_uvs = has(1);
+        const auto has_normals = has(2);
+
+        triangles.positions.reserve(keys.size());
+        for (const auto& key : keys)
+        {
+            triangles.positions.push_back(positions[key[0] - 1]);
+
+            if (has_uvs)
+            {
+                triangles.uvs.push_back(key[1] > 0 ? uvs[key[1] - 1] : glm::vec2{ 0.f });
+            }
+            if (has_normals)
+            {
+                // a zero normal makes the face fall back to flat shading
+                triangles.normals.push_back(key[2] > 0 ? normals[key[2] - 1] : glm::vec3{ 0.f });
+            }
+        }
+
+        return Mesh{ std::move(triangles) };
     }
 }
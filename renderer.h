@@ -1,7 +1,18 @@
 #ifndef IRRADIANCE_RENDERER_H
 #define IRRADIANCE_RENDERER_H
 
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
 #include "utility.h"
+#include "arena.h"
+#include "hierarchy.h"
+#include "packet.h"
+#include "primitives.h"
+#include "volume.h"
+#include "material.h"
 #include "olcPixelGameEngine.h"
 
 // renderer.h
@@ -9,40 +20,42 @@
 
 namespace ir
 {
-    struct BoundingVolume
+    // point on an emitter chosen for a particular reference point, see Object::sample_from
+    struct SurfaceSample
     {
-    public:
-        glm::vec3 origin;
-        glm::vec3 size;
-
-    public:
-        BoundingVolume(const glm::vec3& origin, const glm::vec3& size)
-            : origin{ origin }, size{ size }
-        {
-        }
-
-    public:
-        bool contains(const glm::vec3& point) const;
-        bool intersects(const BoundingVolume& other) const;
+        glm::vec3 position;
+        glm::vec3 normal;
+        // per unit solid angle at the reference point; zero when nothing could be sampled
+        Real pdf = 0.f;
     };
 
     struct Object
     {
     public:
-        PBRMaterial material;
+        // entry in the scene material table
+        MaterialId material;
         Real area = 0.f;
         glm::vec3 centroid = glm::vec3{ 0.f };
 
     public:
-        Object(const PBRMaterial& material) 
+        Object(MaterialId material) 
             : material{ material }
         {
         }
         virtual ~Object() = default;
 
     public:
-        virtual RayIntersection intersect(const Ray& ray) = 0;
-        virtual glm::vec3 sample() = 0;
+        // tag used to compile the object into its compact form, see PrimitiveStore
+        virtual PrimitiveType type() const = 0;
+        // point on the surface from a sample u in the unit square (see Sampler)
+        virtual glm::vec3 sample(const glm::vec2& u) = 0;
+        // density of sample() at a point it returned, per unit surface area
+        virtual Real pdf(const glm::vec3& position) = 0;
+        // point on the surface chosen by its direction from reference, so that samples concentrate on what reference
+        // can actually see. shapes without a better strategy convert sample() into solid angle
+        virtual SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u);
+        // density of sample_from(reference) at a point it returned, per unit solid angle at reference
+        virtual Real pdf_from(const glm::vec3& reference, const glm::vec3& position);
         virtual glm::vec3 normal_of(const glm::vec3& position) = 0;
         virtual BoundingVolume bounds() = 0;
     };
@@ -54,7 +67,7 @@ namespace ir
         Real radius;
 
     public:
-        Sphere(const glm::vec3& center, Real radius, const PBRMaterial& material)
+        Sphere(const glm::vec3& center, Real radius, MaterialId material)
             : center{ center }, radius{ radius }, Object{ material }
         {
             area = 4.f * glm::pi<Real>() * radius * radius;
@@ -62,10 +75,16 @@ namespace ir
         }
 
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
+
+    public:
+        SpherePrimitive compact();
     };
 
     struct Triangle : public Object
@@ -73,31 +92,25 @@ namespace ir
     public:   
         glm::vec3 v0, v1, v2;
         glm::vec2 uv0, uv1, uv2;
-        glm::vec3 edge0, edge1;
-        Real d00, d01, d11;
-        Real denominator;
         glm::vec3 normal;
 
     public:
-        Triangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2, const PBRMaterial& material)
+        Triangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec2& uv0, const glm::vec2& uv1, const glm::vec2& uv2, MaterialId material)
             : v0{ v0 }, v1{ v1 }, v2{ v2 }, uv0{ uv0 }, uv1{ uv1 }, uv2{ uv2 }, Object{ material }
         {
-            // cache to avoid recomputing per intersection
-            edge0 = v1 - v0;
-            edge1 = v2 - v0;
-            d00 = glm::dot(edge0, edge0);
-            d01 = glm::dot(edge0, edge1);
-            d11 = glm::dot(edge1, edge1);
-            denominator = (d00 * d11) - (d01 * d01);
-            normal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
+            const auto orthogonal = glm::cross(v1 - v0, v2 - v0);
+            normal = glm::normalize(orthogonal);
             // area is half the equivalent parallelogram
-            area = .5f * glm::length(glm::cross(edge0, edge1));
+            area = .5f * glm::length(orthogonal);
             centroid = (v0 + v1 + v2) / 3.f;
         }
 
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
     };
@@ -114,7 +127,7 @@ namespace ir
 
 
     public:
-        Quadrilateral(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const PBRMaterial& material)
+        Quadrilateral(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, MaterialId material)
             : v0{ v0 }, Object{ material }
         {
             this->v1 = v0 - v1;
@@ -126,15 +139,21 @@ namespace ir
             reciprocal = orthogonal / glm::dot(orthogonal, orthogonal);
             // area is equal to cross product parallogram
             area = glm::length(orthogonal);
-            // parallelogram centroid: r0 + (u + v) / 2
-            centroid = v0 + (this->v1 + this->v2) / 2.f;
+            // parallelogram centroid: r0 - (u + v) / 2 since the edge vectors point back toward the origin corner
+            centroid = v0 - (this->v1 + this->v2) / 2.f;
         }
     
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
+
+    public:
+        QuadrilateralPrimitive compact();
     }; 
 
     struct Cuboid : public Object
@@ -144,7 +163,7 @@ namespace ir
         glm::vec3 size;
 
     public:
-        Cuboid(const glm::vec3& origin, const glm::vec3& size, const PBRMaterial& material)
+        Cuboid(const glm::vec3& origin, const glm::vec3& size, MaterialId material)
             : origin{ origin }, size{ size }, Object{ material }
         {
             area = 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
@@ -152,42 +171,67 @@ namespace ir
         }
 
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
+
+    public:
+        CuboidPrimitive compact();
     };
 
     struct Quadric : public Object
     {
     public:
-        // Ax^2 + By^2 + Cz^2 + Dxy + Exz + Fyz + Gx + Hy + Iz + J = 0
+        // rays cast through the container along each axis to find the surface, per side of the container
+        static constexpr std::uint32_t RESOLUTION = 32;
+
+    public:
+        // Ax^2 + By^2 + Cz^2 + Dxy + Exz + Fyz + Gx + Hy + Iz + J = 0, relative to the centroid
         Real A, B, C, D, E, F, G, H, I, J;
-        Cuboid* container;
+        // clip cube, held by value since it is never placed in a mesh of its own
+        Cuboid container;
+
+    private:
+        // where the grid of rays crossed the surface. each crossing stands for the patch of surface around it, of
+        // the area held by patch_cdf, and the cell of the grid it was found in
+        std::vector<glm::vec3> patches;
+        std::vector<std::uint32_t> patch_cells;
+        // running total of patch area, normalized, for choosing patches in proportion to their area
+        std::vector<Real> patch_cdf;
+        // first patch of each cell, with one past the last patch at the end
+        std::vector<std::uint32_t> cells;
 
     public:
-        Quadric(Real A, Real B, Real C, Real D, Real E, Real F, Real G, Real H, Real I, Real J, const glm::vec3& origin, const glm::vec3& size, const PBRMaterial& material)
-            : A{ A }, B{ B }, C{ C }, D{ D }, E{ E }, F{ F }, G{ G }, H{ H }, I{ I }, J{ J }, Object{ material }
+        Quadric(Real A, Real B, Real C, Real D, Real E, Real F, Real G, Real H, Real I, Real J, const glm::vec3& origin, const glm::vec3& size, MaterialId material)
+            : A{ A }, B{ B }, C{ C }, D{ D }, E{ E }, F{ F }, G{ G }, H{ H }, I{ I }, J{ J }, container{ origin, size, material }, Object{ material }
         {
-            // quick and dirty approximations since there don't seem to be any easy closed-form solutions
-            area = size.x * size.z;
             centroid = origin + size / 2.f;
-            container = new Cuboid{ origin, size, material };
+            tabulate();
         }
 
     private:
-        Real function(const glm::vec3& position)
-        {
-            return (A * position.x * position.x) + (B * position.y * position.y) + (C * position.z * position.z) + 
-                   (D * position.x * position.y) + (E * position.x * position.z) + (F * position.y * position.z) +
-                   (G * position.x) + (H * position.y) + (I * position.z) + J;
-        }
+        // finds the surface patches and the total area from them
+        void tabulate();
+        // distances along axis from origin at which the surface lies inside the container; returns how many
+        std::uint32_t crossings(const glm::vec3& origin, std::uint32_t axis, std::array<Real, 2>& distances) const;
+        // grid cell of axis whose rays pass through position
+        std::uint32_t cell_of(const glm::vec3& position, std::uint32_t axis) const;
+        // point chosen by u, or false with the chosen patch when the surface cannot be found across its cell
+        bool place(const glm::vec2& u, glm::vec3& position) const;
 
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        // bounded time however thin the surface; points are not quite uniform by area, but pdf() is exact for them
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
+
+    public:
+        QuadricPrimitive compact();
     };
 
     struct Colloid : public Object
@@ -198,52 +242,228 @@ namespace ir
         
     public:
         Colloid(Real density, Object* container)
-            : density{ density }, container{ container }, Object{ container->material }
+            : Object{ container->material }, density{ density }, container{ container }
         {
+            centroid = container->centroid;
         }
 
     public:
-        RayIntersection intersect(const Ray& ray) override;
-        glm::vec3 sample() override;
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
         glm::vec3 normal_of(const glm::vec3& position) override;
         BoundingVolume bounds() override;
     };
 
-    using Mesh = std::vector<Object*>;
+    // heterogeneous medium filling a closed container, with its density given by a grid over the container's bounds
+    struct Volume : public Object
+    {
+    public:
+        Object* container;
+        DensityGrid grid;
+
+    public:
+        Volume(Object* container, const glm::uvec3& resolution, std::vector<Real> voxels)
+            : Object{ container->material }, container{ container }, grid{ container->bounds(), resolution, std::move(voxels) }
+        {
+            centroid = container->centroid;
+        }
+
+        // density is baked into the grid once, so that any field, noise included, has majorants that truly bound it
+        Volume(Object* container, const glm::uvec3& resolution, const std::function<Real(const glm::vec3&)>& density)
+            : Object{ container->material }, container{ container }, grid{ container->bounds(), resolution, density }
+        {
+            centroid = container->centroid;
+        }
+
+    public:
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
+        glm::vec3 normal_of(const glm::vec3& position) override;
+        BoundingVolume bounds() override;
+    };
+
+    struct Mesh
+    {
+    public:
+        // authoring objects, not owned; scenes make them in the same arena as the mesh
+        std::vector<Object*> objects;
+        // bottom-level acceleration structure, built once and shared by every instance of this mesh
+        BoundingVolumeHierarchy hierarchy;
+        // compact type-tagged reference per entry of hierarchy.indices, grouped by type within each leaf
+        std::vector<PrimitiveReference> primitives;
+        // indexed triangles plus every other primitive compiled into per-type arrays, intersected without virtual dispatch
+        PrimitiveStore store;
+        // optional cache of each leaf's triangles packed for SIMD intersection, ahead of any other primitives in that leaf
+        std::vector<TrianglePacket> packets;
+        // packet index per hierarchy node, NO_PACKET for interior nodes and leaves without (cached) triangles
+        std::vector<std::uint32_t> leaf_packets;
+        // whether any primitive is a colloid or volume, which shadow rays must pass through rather than stop at
+        bool media = false;
+
+    public:
+        static constexpr std::uint32_t NO_PACKET = std::numeric_limits<std::uint32_t>::max();
+        // packets duplicate their vertices, so meshes that would need more than this many bytes of them
+        // intersect straight from the index buffer instead
+        static constexpr std::size_t PACKET_BUDGET = std::size_t{ 256 } << 20;
+
+    public:
+        Mesh() = default;
+        Mesh(std::initializer_list<Object*> objects)
+            : objects{ objects }
+        {
+            build();
+        }
+        Mesh(std::vector<Object*>&& objects)
+            : objects{ std::move(objects) }
+        {
+            build();
+        }
+        Mesh(IndexedTriangles&& triangles)
+        {
+            store.triangles = std::move(triangles);
+            build();
+        }
+
+    public:
+        // surface record for a hit found while traversing this mesh, in mesh-local space
+        RayIntersection resolve(const Hit& hit, const Ray& ray, const MaterialTable& materials) const;
+
+    public:
+        auto begin() const { return objects.begin(); }
+        auto end() const { return objects.end(); }
+
+    private:
+        void build();
+    };
 
     struct MeshInstance
     {
     public:
         glm::mat4 transform;
         glm::mat4 inverse;
+        glm::mat3 normal_matrix;
         const Mesh& mesh;
         BoundingVolume volume;
+        // when set, replaces the material of every primitive in the mesh so that one loaded mesh can be shared
+        // between differently shaded instances
+        MaterialId material;
 
     public:
-        MeshInstance(const glm::mat4& transform, const Mesh& mesh)
-            : transform{ transform }, mesh{ mesh }, volume{ glm::vec3{ std::numeric_limits<Real>::max() }, glm::vec3{ std::numeric_limits<Real>::min() } }
+        MeshInstance(const glm::mat4& transform, const Mesh& mesh, MaterialId material = NO_MATERIAL)
+            : transform{ transform }, mesh{ mesh }, volume{ glm::vec3{ 0.f }, glm::vec3{ 0.f } }, material{ material }
         {
             inverse = glm::inverse(transform);
+            normal_matrix = glm::transpose(glm::mat3{ inverse });
 
-            for (const auto& object : mesh)
+            if (mesh.hierarchy.empty())
             {
-                if (!object)
-                {
-                    continue;
-                }
+                return;
+            }
+
+            // world-space bounds enclose all eight transformed corners of the local root box
+            const auto& root = mesh.hierarchy.nodes[0];
+            auto minimum = glm::vec3{ std::numeric_limits<Real>::max() };
+            auto maximum = glm::vec3{ -std::numeric_limits<Real>::max() };
 
-                const auto bounds = object->bounds();
-                volume.origin = glm::min(volume.origin, glm::vec3{ transform * glm::vec4{ bounds.origin, 1.f } });
-                volume.size = glm::max(volume.size, glm::vec3{ transform * glm::vec4{ bounds.origin + bounds.size, 1.f } });
+            for (auto corner = 0; corner < 8; corner++)
+            {
+                const auto local = glm::vec3
+                {
+                    (corner & 1) ? root.maximum.x : root.minimum.x,
+                    (corner & 2) ? root.maximum.y : root.minimum.y,
+                    (corner & 4) ? root.maximum.z : root.minimum.z,
+                };
+
+                const auto world = glm::vec3{ transform * glm::vec4{ local, 1.f } };
+                minimum = glm::min(minimum, world);
+                maximum = glm::max(maximum, world);
             }
+
+            volume = BoundingVolume{ minimum, maximum - minimum };
         }
 
     public:
-        RayIntersection intersect(const Ray& ray) const;
+        // nearest hit in front of t_max without evaluating its surface; depths are world-space distances along ray
+        bool intersect(const Ray& ray, Real t_max, Hit& hit) const;
+        // evaluates the surface of a hit returned by intersect() for the same ray, in world space
+        RayIntersection resolve(const Ray& ray, const Hit& hit, const MaterialTable& materials) const;
+        bool occluded(const Ray& ray, Real t_max) const;
+        // fraction of light carried along ray up to t_max through any media, or zero once anything opaque is in the way
+        Real transmittance(const Ray& ray, Real t_max) const;
         BoundingVolume bounds() const;
+        // material that this instance shades the given primitive of its mesh with
+        MaterialId material_of(const Object& object) const;
+
+    private:
+        Ray localize(const Ray& ray) const;
+    };
+
+    // an authoring object seen through the transform of an instance, so that an emitter in a moved, turned or scaled
+    // instance is sampled where the instance draws it. only ever sampled from, never compiled into a mesh
+    struct InstancedObject : public Object
+    {
+    public:
+        // points per side of the grid over which the world-space area is measured
+        static constexpr std::uint32_t AREA_SAMPLES = 8;
+
+    public:
+        Object* object;
+        glm::mat4 transform;
+        glm::mat4 inverse;
+        glm::mat3 normal_matrix;
+        Real determinant;
+
+    public:
+        InstancedObject(Object* object, const MeshInstance& instance);
+
+    public:
+        PrimitiveType type() const override;
+        glm::vec3 sample(const glm::vec2& u) override;
+        Real pdf(const glm::vec3& position) override;
+        SurfaceSample sample_from(const glm::vec3& reference, const glm::vec2& u) override;
+        Real pdf_from(const glm::vec3& reference, const glm::vec3& position) override;
+        glm::vec3 normal_of(const glm::vec3& position) override;
+        BoundingVolume bounds() override;
+
+    private:
+        glm::vec3 localize(const glm::vec3& position) const;
+        glm::vec3 globalize(const glm::vec3& position) const;
+        // world-space area per unit of local area about a local point, by Nanson's formula
+        Real stretch(const glm::vec3& position) const;
+    };
+
+    struct Scene
+    {
+    public:
+        // owns every mesh and primitive of the scene, laid out contiguously in the order they were made
+        Arena arena;
+        // materials of every primitive and instance override in the arena
+        MaterialTable materials;
+        std::vector<MeshInstance> instances;
+        // top-level acceleration structure over the world-space instance bounds
+        BoundingVolumeHierarchy hierarchy;
+        // whether any instance's mesh holds media; shadow rays in scenes without any can use occluded()
+        bool media = false;
+
+    public:
+        void build();
+        // releases every mesh, primitive and material at once so that another scene can be loaded in its place
+        void clear();
+        RayIntersection intersect(const Ray& ray) const;
+        // any-hit shadow test, exact only when the scene has no media
+        bool occluded(const Ray& ray, Real t_max) const;
+        Real transmittance(const Ray& ray, Real t_max) const;
     };
 
-    Mesh load_obj(const std::string& filepath, const PBRMaterial& default_material);
+    // every face of the file with the one material; an empty mesh if the file cannot be opened, and a
+    // std::runtime_error naming the line of any face corner that refers to an element not declared before it
+    Mesh load_obj(const std::string& filepath, MaterialId material);
 }
 
 #endif
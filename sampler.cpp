@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "sampler.h"
+#include "random.h"
+
+// sampler.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace
+{
+    constexpr auto PRIMES = std::array<std::uint32_t, 32>
+    {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+        59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+    };
+
+    // largest float below one, so that rounding never produces a sample of exactly one
+    constexpr auto ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+
+    // dimensions with a Kronecker step of their own; deeper ones fall back to PCG
+    constexpr auto KRONECKER_DIMENSIONS = 256uz;
+
+    ir::Real to_unit(std::uint32_t bits)
+    {
+        return static_cast<ir::Real>(bits >> 8) * 0x1p-24f;
+    }
+
+    ir::Real wrap(ir::Real value)
+    {
+        value -= glm::floor(value);
+        return glm::min(value, ONE_MINUS_EPSILON);
+    }
+
+    std::uint32_t hash(std::uint64_t value, std::uint64_t salt)
+    {
+        return static_cast<std::uint32_t>(ir::mix(value ^ ir::mix(salt)));
+    }
+
+    std::uint32_t reverse_bits(std::uint32_t x)
+    {
+        x = (x << 16) | (x >> 16);
+        x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+        x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+        x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+        x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+        return x;
+    }
+
+    ir::Real radical_inverse(std::uint32_t base, std::uint64_t index)
+    {
+        const auto inverse = 1.0 / base;
+        auto reversed = std::uint64_t{ 0 };
+        auto factor = 1.0;
+
+        while (index > 0)
+        {
+            const auto next = index / base;
+            const auto digit = index - next * base;
+            reversed = reversed * base + digit;
+            factor *= inverse;
+            index = next;
+        }
+
+        return glm::min(static_cast<ir::Real>(reversed * factor), ONE_MINUS_EPSILON);
+    }
+
+    ir::Real halton(std::uint64_t index, std::uint32_t dimension, std::uint64_t seed)
+    {
+        if (dimension >= PRIMES.size())
+        {
+            // large bases are poorly distributed at the sample counts used here anyway
+            return ir::rng().uniform();
+        }
+
+        // Cranley-Patterson rotation: each pixel shifts the whole sequence by its own offset, which keeps the
+        // points of a pixel stratified while decorrelating neighbouring pixels
+        return wrap(radical_inverse(PRIMES[dimension], index) + to_unit(hash(seed, dimension)));
+    }
+
+    // second Sobol dimension (primitive polynomial x + 1), whose direction numbers are each the previous one
+    // xored with itself shifted right. the index is scrambled to a full 32 bits before it gets here, so rather
+    // than xoring one direction per set bit the directions are pre-combined for every value of each index byte
+    constexpr auto SOBOL_TABLES = []
+    {
+        auto directions = std::array<std::uint32_t, 32>{};
+        directions[0] = 1u << 31;
+        for (auto bit = 1uz; bit < directions.size(); bit++)
+        {
+            directions[bit] = directions[bit - 1] ^ (directions[bit - 1] >> 1);
+        }
+
+        auto tables = std::array<std::array<std::uint32_t, 256>, 4>{};
+        for (auto byte = 0uz; byte < tables.size(); byte++)
+        {
+            for (auto value = 0uz; value < 256; value++)
+            {
+                for (auto bit = 0uz; bit < 8; bit++)
+                {
+                    if (value & (1uz << bit))
+                    {
+                        tables[byte][value] ^= directions[8 * byte + bit];
+                    }
+                }
+            }
+        }
+        return tables;
+    }();
+
+    std::uint32_t sobol(std::uint32_t index, std::uint32_t dimension)
+    {
+        if (dimension == 0)
+        {
+            // the first dimension is the van der Corput sequence, which is just the bit-reversed index
+            return reverse_bits(index);
+        }
+
+        return SOBOL_TABLES[0][index & 0xff] ^ SOBOL_TABLES[1][(index >> 8) & 0xff] ^
+               SOBOL_TABLES[2][(index >> 16) & 0xff] ^ SOBOL_TABLES[3][index >> 24];
+    }
+
+    // hash that only mixes bits upward, so applied to reversed bits it acts as an Owen scramble
+    // https://psychopath.io/post/2021_01_30_building_a_better_lk_hash
+    std::uint32_t laine_karras_permutation(std::uint32_t x, std::uint32_t seed)
+    {
+        x ^= x * 0x3d20adeau;
+        x += seed;
+        x *= (seed >> 16) | 1;
+        x ^= x * 0x05526c56u;
+        x ^= x * 0x53a22864u;
+        return x;
+    }
+
+    std::uint32_t nested_uniform_scramble(std::uint32_t x, std::uint32_t seed)
+    {
+        return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+    }
+
+    // Burley, "Practical Hash-based Owen Scrambling" https://jcgt.org/published/0009/04/01/
+    // every dimension pair scrambles the same (0,2)-sequence with its own seed and visits its points in a
+    // shuffled order, so pairs stay stratified without correlating with one another
+    glm::vec2 sobol_2d(std::uint64_t index, std::uint32_t dimension, std::uint64_t seed)
+    {
+        const auto pair_seed = hash(seed, dimension);
+        const auto shuffled = nested_uniform_scramble(static_cast<std::uint32_t>(index), pair_seed);
+
+        const auto x = nested_uniform_scramble(sobol(shuffled, 0), hash(pair_seed, 0));
+        const auto y = nested_uniform_scramble(sobol(shuffled, 1), hash(pair_seed, 1));
+
+        return glm::vec2{ to_unit(x), to_unit(y) };
+    }
+
+    // first half of sobol_2d only
+    ir::Real sobol_1d(std::uint64_t index, std::uint32_t dimension, std::uint64_t seed)
+    {
+        const auto pair_seed = hash(seed, dimension);
+        const auto shuffled = nested_uniform_scramble(static_cast<std::uint32_t>(index), pair_seed);
+
+        return to_unit(nested_uniform_scramble(sobol(shuffled, 0), hash(pair_seed, 0)));
+    }
+
+    // dither mask made by void-and-cluster, whose thresholds are spread with no low-frequency structure
+    // http://cv.ulichney.com/papers/1993-void-cluster.pdf
+    std::vector<ir::Real> generate_blue_noise()
+    {
+        constexpr auto SIZE = static_cast<int>(ir::Sampler::BLUE_NOISE_SIZE);
+        constexpr auto COUNT = SIZE * SIZE;
+        constexpr auto SIGMA = 1.5f;
+        static_assert((SIZE & (SIZE - 1)) == 0, "toroidal wrapping masks with SIZE - 1");
+
+        // gaussian falloff over toroidal distance, so that the mask tiles seamlessly
+        auto kernel = std::vector<float>(COUNT);
+        for (auto y = 0; y < SIZE; y++)
+        {
+            for (auto x = 0; x < SIZE; x++)
+            {
+                const auto dx = static_cast<float>(std::min(x, SIZE - x));
+                const auto dy = static_cast<float>(std::min(y, SIZE - y));
+                kernel[x + y * SIZE] = std::exp(-(dx * dx + dy * dy) / (2.f * SIGMA * SIGMA));
+            }
+        }
+
+        auto pattern = std::vector<bool>(COUNT, false);
+        auto energy = std::vector<float>(COUNT, 0.f);
+
+        const auto toggle = [&](int point, bool on)
+        {
+            pattern[point] = on;
+
+            const auto px = point % SIZE;
+            const auto py = point / SIZE;
+            const auto sign = on ? 1.f : -1.f;
+
+            for (auto y = 0; y < SIZE; y++)
+            {
+                for (auto x = 0; x < SIZE; x++)
+                {
+                    energy[x + y * SIZE] += sign * kernel[((x - px) & (SIZE - 1)) + ((y - py) & (SIZE - 1)) * SIZE];
+                }
+            }
+        };
+
+        // densest set point and emptiest unset point
+        const auto tightest_cluster = [&]()
+        {
+            auto best = -1;
+            for (auto point = 0; point < COUNT; point++)
+            {
+                if (pattern[point] && (best < 0 || energy[point] > energy[best]))
+                {
+                    best = point;
+                }
+            }
+            return best;
+        };
+
+        const auto largest_void = [&]()
+        {
+            auto best = -1;
+            for (auto point = 0; point < COUNT; point++)
+            {
+                if (!pattern[point] && (best < 0 || energy[point] < energy[best]))
+                {
+                    best = point;
+                }
+            }
+            return best;
+        };
+
+        // fixed seed so that the mask is identical on every run
+        auto generator = ir::Random{};
+        auto ones = 0;
+        while (ones < COUNT / 10)
+        {
+            const auto point = static_cast<int>(generator.integer(COUNT));
+            if (!pattern[point])
+            {
+                toggle(point, true);
+                ones++;
+            }
+        }
+
+        // move points from clusters into voids until the initial pattern is evenly spread. the swap normally
+        // settles long before the cap, which only guards against rounding in the energies making it cycle
+        for (auto iteration = 0; iteration < COUNT; iteration++)
+        {
+            const auto cluster = tightest_cluster();
+            toggle(cluster, false);
+
+            const auto empty = largest_void();
+            if (empty == cluster)
+            {
+                toggle(cluster, true);
+                break;
+            }
+
+            toggle(empty, true);
+        }
+
+        auto rank = std::vector<int>(COUNT, 0);
+        const auto initial_pattern = pattern;
+        const auto initial_energy = energy;
+
+        // ranks below the initial pattern by removing its tightest clusters first
+        for (auto r = ones - 1; r >= 0; r--)
+        {
+            const auto cluster = tightest_cluster();
+            toggle(cluster, false);
+            rank[cluster] = r;
+        }
+
+        // and ranks above it by filling the largest voids first
+        pattern = initial_pattern;
+        energy = initial_energy;
+        for (auto r = ones; r < COUNT; r++)
+        {
+            const auto empty = largest_void();
+            toggle(empty, true);
+            rank[empty] = r;
+        }
+
+        auto mask = std::vector<ir::Real>(COUNT);
+        for (auto point = 0; point < COUNT; point++)
+        {
+            mask[point] = (static_cast<ir::Real>(rank[point]) + .5f) / static_cast<ir::Real>(COUNT);
+        }
+
+        return mask;
+    }
+
+    ir::Real blue_noise(std::uint32_t x, std::uint32_t y, std::uint32_t dimension)
+    {
+        // built on first use; static initialization is thread-safe
+        static const auto mask = generate_blue_noise();
+
+        constexpr auto SIZE = ir::Sampler::BLUE_NOISE_SIZE;
+
+        // every dimension reads the mask at its own toroidal shift so that dimensions stay uncorrelated
+        const auto shift = ir::mix(dimension);
+        const auto u = (x + static_cast<std::uint32_t>(shift)) % SIZE;
+        const auto v = (y + static_cast<std::uint32_t>(shift >> 32)) % SIZE;
+
+        return mask[u + v * SIZE];
+    }
+
+    // fractional part of index * step in double precision, which stays exact far beyond a float's 24 bits
+    ir::Real lattice(std::uint64_t index, double step)
+    {
+        return static_cast<ir::Real>(std::fmod(static_cast<double>(index) * step, 1.0));
+    }
+
+    // step of each dimension of a Kronecker sequence: the fractional square roots of the square-free integers from 2.
+    // these are linearly independent over the rationals, so any set of dimensions is jointly equidistributed, whereas
+    // dimensions sharing one step would each be the same sequence shifted and perfectly correlated with one another
+    // https://extremelearning.com.au/unreasonable-effectiveness-of-quasirandom-sequences/
+    double kronecker_step(std::uint32_t dimension)
+    {
+        // built on first use; static initialization is thread-safe
+        static const auto steps = []
+        {
+            auto steps = std::vector<double>{};
+            for (auto n = 2u; steps.size() < KRONECKER_DIMENSIONS; n++)
+            {
+                auto square_free = true;
+                for (auto factor = 2u; factor * factor <= n; factor++)
+                {
+                    square_free = square_free && n % (factor * factor) != 0;
+                }
+
+                if (square_free)
+                {
+                    const auto root = std::sqrt(static_cast<double>(n));
+                    steps.push_back(root - std::floor(root));
+                }
+            }
+            return steps;
+        }();
+
+        return steps[dimension];
+    }
+
+    ir::Real blue_noise_kronecker(std::uint32_t x, std::uint32_t y, std::uint64_t index, std::uint32_t dimension)
+    {
+        if (dimension >= KRONECKER_DIMENSIONS)
+        {
+            return ir::rng().uniform();
+        }
+
+        return wrap(blue_noise(x, y, dimension) + lattice(index, kronecker_step(dimension)));
+    }
+}
+
+namespace ir
+{
+    Sampler::Sampler(SamplerType type, std::uint32_t x, std::uint32_t y, std::uint64_t seed)
+        : type{ type }, x{ x }, y{ y }, seed{ mix(seed ^ mix((static_cast<std::uint64_t>(y) << 32) | x)) }
+    {
+    }
+
+    void Sampler::start(std::uint64_t index)
+    {
+        this->index = index;
+        dimension = 0;
+    }
+
+    Real Sampler::next_1d()
+    {
+        const auto d = dimension++;
+
+        switch (type)
+        {
+            case SamplerType::INDEPENDENT:
+                return rng().uniform();
+
+            case SamplerType::HALTON:
+                return halton(index, d, seed);
+
+            case SamplerType::SOBOL:
+                return sobol_1d(index, d, seed);
+
+            case SamplerType::BLUE_NOISE:
+                return blue_noise_kronecker(x, y, index, d);
+        }
+
+        return 0.f;
+    }
+
+    glm::vec2 Sampler::next_2d()
+    {
+        const auto d = dimension;
+        dimension += 2;
+
+        switch (type)
+        {
+            case SamplerType::INDEPENDENT:
+            {
+                const auto u = rng().uniform();
+                return glm::vec2{ u, rng().uniform() };
+            }
+
+            case SamplerType::HALTON:
+                return glm::vec2{ halton(index, d, seed), halton(index, d + 1, seed) };
+
+            case SamplerType::SOBOL:
+                return sobol_2d(index, d, seed);
+
+            case SamplerType::BLUE_NOISE:
+                return glm::vec2{ blue_noise_kronecker(x, y, index, d), blue_noise_kronecker(x, y, index, d + 1) };
+        }
+
+        return glm::vec2{ 0.f };
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef IRRADIANCE_SAMPLER_H
+#define IRRADIANCE_SAMPLER_H
+
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+
+// sampler.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    enum class SamplerType
+    {
+        // uncorrelated PCG samples, as before the sampler existed
+        INDEPENDENT,
+        // radical inverses in the first prime bases, randomly rotated per pixel
+        HALTON,
+        // Owen-scrambled Sobol (0,2)-sequence pairs, shuffled per dimension
+        SOBOL,
+        // Kronecker sequence with its own irrational step per dimension, offset per pixel by a blue-noise mask, so that
+        // the error left at low sample counts is spread evenly across the screen instead of clumping; best suited to
+        // interactive frames
+        BLUE_NOISE,
+    };
+
+    // supplies the [0, 1) numbers for one pixel. every sample of the pixel draws its dimensions in the same order
+    // (camera first, then a fixed set per bounce), so dimension d of consecutive samples forms a well-stratified
+    // sequence rather than independent noise. cheap enough to be made per pixel on the stack of each worker
+    class Sampler
+    {
+    public:
+        static constexpr std::uint32_t BLUE_NOISE_SIZE = 64;
+
+    private:
+        SamplerType type;
+        std::uint32_t x, y;
+        // decorrelates pixels from one another
+        std::uint64_t seed;
+        std::uint64_t index = 0;
+        std::uint32_t dimension = 0;
+
+    public:
+        Sampler(SamplerType type, std::uint32_t x, std::uint32_t y, std::uint64_t seed);
+
+    public:
+        // begins sample number index of the pixel, starting over at the first dimension
+        void start(std::uint64_t index);
+        Real next_1d();
+        // consumes two dimensions
+        glm::vec2 next_2d();
+    };
+}
+
+#endif
@@ -12,15 +12,20 @@
 
 namespace ir
 {
-    MeshInstance test_spheres() 
+    // each scene makes its mesh and primitives in the arena of the given scene and its materials in the scene's table,
+    // both of which must outlive the returned instance
+    MeshInstance test_spheres(Scene& scene) 
     {
-        static const auto mesh = Mesh
+        auto& arena = scene.arena;
+        auto& materials = scene.materials;
+
+        const auto& mesh = *arena.make<Mesh>(std::vector<Object*>
         {
-            new Sphere
-            {
+            arena.make<Sphere>
+            (
                 glm::vec3{ 120.f, -120.f, 150.f },
                 60.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 0.f, 0.f, 0.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -28,52 +33,52 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 1.f,
                     .texture = rock.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 120.f, -120.f, 0.f },
                 60.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .1f, .1f, .8f },
                     .emission = glm::vec3{ 1e2f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 0.1f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 0.f, -6.f, 5.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = .9f,
                     .anisotropy = 0.f,
                     .roughness = 0.f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 6.f, -1.f, 5.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 1.f,
                     .anisotropy = 0.f,
                     .roughness = .1f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 4.f, -1.f, 2.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 0.f, 0.f, 0.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -81,13 +86,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .8f,
                     .texture = gemstone.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 2.f, -1.f, 0.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 0.f, 0.f, 0.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -95,13 +100,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 1.f,
                     .texture = water.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -2.f, -1.f, -1.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 0.f, 0.f, 0.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -109,13 +114,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .2f,
                     .texture = wood.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -4.f, -1.f, 2.f },
                 2.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .56f, .518f, .835f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -123,13 +128,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 1.f,
                     .texture = perlin_high.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -8.f, -1.f, 4.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -138,13 +143,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 0.f,
                     .transmission = 1.f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -8.f, -1.f, 6.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -153,13 +158,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 0.f,
                     .transmission = 1.f,
-                }
-            },
-            new Cuboid
-            {
+                })
+            ),
+            arena.make<Cuboid>
+            (
                 glm::vec3{ -.5f, -4.5f, -.5f },
                 glm::vec3{ .01f, 1.5f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .7f, 1.f, .8f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -168,13 +173,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .01f,
                     .transmission = .91f,
-                }
-            },
-            new Cuboid
-            {
+                })
+            ),
+            arena.make<Cuboid>
+            (
                 glm::vec3{ -.5f, -6.5f, -.5f },
                 glm::vec3{ 1.f, 1.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, 1.f, .6f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -183,13 +188,13 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .3f,
                     .transmission = 1.f,
-                }
-            },
-            new Cuboid
-            {
+                })
+            ),
+            arena.make<Cuboid>
+            (
                 glm::vec3{ -2.5f, -6.5f, -.5f },
                 glm::vec3{ 1.f, 1.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, 1.f, .6f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -198,45 +203,67 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 0.f,
                     .transmission = 1.f,
-                }
-            },
-            new Colloid
-            {
+                })
+            ),
+            arena.make<Colloid>
+            (
                 .25f,
-                new Cuboid
-                {
+                arena.make<Cuboid>
+                (
                     glm::vec3{ 8.5f, -6.5f, -.5f },
                     glm::vec3{ 4.f, 4.f, 4.f },
-                    PBRMaterial
+                    materials.add(PBRMaterial
                     {
                         .albedo = glm::vec3{ .5f, 1.f, .6f },
                         .emission = glm::vec3{ 0.f, 0.f, 0.f },
                         .metallicity = 0.f,
                         .anisotropy = 0.f,
                         .roughness = 0.f,
-                    }
-                },
-            },
-            new Sphere
-            {
+                    })
+                )
+            ),
+            // cloud layer of thresholded turbulence, whose clear gaps the majorant grid steps over
+            arena.make<Volume>
+            (
+                arena.make<Cuboid>
+                (
+                    glm::vec3{ 4.5f, -13.f, -2.f },
+                    glm::vec3{ 10.f, 3.f, 8.f },
+                    materials.add(PBRMaterial
+                    {
+                        .albedo = glm::vec3{ .9f, .9f, .95f },
+                        .emission = glm::vec3{ 0.f, 0.f, 0.f },
+                        .metallicity = 0.f,
+                        .anisotropy = 0.f,
+                        .roughness = 1.f,
+                    })
+                ),
+                glm::uvec3{ 80u, 24u, 64u },
+                [](const glm::vec3& position)
+                {
+                    return glm::max(perlin_low->turbulence<6>(position * .4f) - .15f, 0.f) * 6.f;
+                }
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -8.f, -4.f, 4.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .56f, .518f, .835f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 1.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
-            new Quadric
-            {
+                })
+            ),
+            arena.make<Quadric>
+            (
                 // hyperbolic paraboloid https://en.wikipedia.org/wiki/Paraboloid
                 1.f, -1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f,
                 glm::vec3{ -20.f, -12.f, 0.f },
                 glm::vec3{ 10.f, 10.f, 10.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .25f, .75, .4f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -246,13 +273,13 @@ namespace ir
                     .roughness = .1f,
                     .transmission = .1f,
                     .texture = perlin_low.get(),
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -8.f, -7.f, 4.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, .05f, .025f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -261,99 +288,99 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .05f,
                     .transmission = .1f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ -2.f, -.5f, 5.f },
                 .5f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .1f, 1.f, .1f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = .9f,
                     .anisotropy = 0.f,
                     .roughness = 0.f,
-                }
-            },
-            new Colloid
-            {   
+                })
+            ),
+            arena.make<Colloid>
+            (   
                 1.f,
-                new Sphere
-                {
+                arena.make<Sphere>
+                (
                     glm::vec3{ -2.f, -3.5f, 5.f },
                     2.f,
-                    PBRMaterial
+                    materials.add(PBRMaterial
                     {
                         .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                         .emission = glm::vec3{ 0.f, 0.f, 0.f },
                         .metallicity = 0.f,
                         .anisotropy = 0.f,
                         .roughness = 0.f,
-                    }
-                }
-            },
-            new Sphere
-            {
+                    })
+                )
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 0.f, -2.f, 5.f },
                 1.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, .1f, .1f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = .25f,
                     .anisotropy = 0.f,
                     .roughness = .25f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 3.f, -1.5f, 5.f },
                 1.5f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .1f, .1f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = .8f,
                     .anisotropy = 0.f,
                     .roughness = .1f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 3.f, -4.5f, 5.f },
                 1.5f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .9f, .5f, .1f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = .9f,
                     .anisotropy = 0.f,
                     .roughness = .4f,
-                }
-            },
-            new Sphere
-            {
+                })
+            ),
+            arena.make<Sphere>
+            (
                 glm::vec3{ 0.f, 1000.f, 5.f },
                 1000.f,
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .25f, .5f, .75f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
-            new Triangle
-            {
+                })
+            ),
+            arena.make<Triangle>
+            (
                 glm::vec3{ -50.f, 2.f, 5.f },
                 glm::vec3{ 50.f, -50.f, 50.f },
                 glm::vec3{ 0.f, 2.f, 50.f },
                 glm::vec2{ 0.f, 1.f },
                 glm::vec2{ 1.f, 0.f },
                 glm::vec2{ .5f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -361,14 +388,14 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = .5f,
                     .texture = gemstone.get(),
-                }
-            },
-            new Quadrilateral
-            {
+                })
+            ),
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ 50.f, 0.f, 0.f },
                 glm::vec3{ 50.f, -20.f, 0.f },
                 glm::vec3{ 50.f, 0.f, 50.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -376,14 +403,14 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 1.f,
                     .texture = wood.get(),
-                }
-            },
-            new Quadrilateral
-            {
+                })
+            ),
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ 50.f, 0.f, -50.f },
                 glm::vec3{ 50.f, -20.f, -50.f },
                 glm::vec3{ 50.f, 0.f, 0.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -391,14 +418,14 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 1.f,
                     .texture = perlin_low.get(),
-                }
-            },
-            new Quadrilateral
-            {
+                })
+            ),
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ 1.f, -10.f, -1.f },
                 glm::vec3{ -1.f, -10.f, -1.f },
                 glm::vec3{ 1.f, -10.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .5f, .5f, .5f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
@@ -406,9 +433,9 @@ namespace ir
                     .anisotropy = 0.f,
                     .roughness = 0.f,
                     .texture = water.get(),
-                }
-            }
-        };
+                })
+            )
+        });
 
         return
         {
@@ -417,122 +444,125 @@ namespace ir
         };
     };
 
-    MeshInstance cornell_box()
+    MeshInstance cornell_box(Scene& scene)
     {
-        static const auto mesh = Mesh
+        auto& arena = scene.arena;
+        auto& materials = scene.materials;
+
+        const auto& mesh = *arena.make<Mesh>(std::vector<Object*>
         {
             // left wall (red)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ 1.f, 1.f, 1.f },
                 glm::vec3{ 1.f, -1.f, 1.f },
                 glm::vec3{ 1.f, 1.f, -1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, .25f, .25f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // right wall (green)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ -1.f, 1.f, -1.f },
                 glm::vec3{ -1.f, -1.f, -1.f },
                 glm::vec3{ -1.f, 1.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .25f, 1.f, .25f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // back wall (white)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ -1.f, 1.f, -1.f },
                 glm::vec3{ -1.f, -1.f, -.95f },
                 glm::vec3{ 1.f, 1.f, -1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f , 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // floor (white)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ -1.f, -1.f, -1.f },
                 glm::vec3{ -1.f, -1.f, 1.f },
                 glm::vec3{ 1.f, -1.f, -1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // ceiling (white)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ -1.f, 1.f, -1.f },
                 glm::vec3{ 1.f, 1.f, -1.f },
                 glm::vec3{ -1.f, 1.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // front wall (blue)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{  2.f, 1.f, 1.f },
                 glm::vec3{  2.f, -2.f, .95f },
                 glm::vec3{ -1.f, 1.f, 1.f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ .25f, .25f, 1.f },
                     .emission = glm::vec3{ 0.f, 0.f, 0.f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            },
+                })
+            ),
 
             // light source (emissive white)
-            new Quadrilateral
-            {
+            arena.make<Quadrilateral>
+            (
                 glm::vec3{ .25f, -.99f, .25f },
                 glm::vec3{ -.25f, -.99f, .25f },
                 glm::vec3{ .25f, -.99f, -.25f },
-                PBRMaterial
+                materials.add(PBRMaterial
                 {
                     .albedo = glm::vec3{ 1.f, 1.f, 1.f },
                     .emission = glm::vec3{ .2f },
                     .metallicity = 0.f,
                     .anisotropy = 0.f,
                     .roughness = 1.f,
-                }
-            }
-        };
+                })
+            )
+        });
 
         return MeshInstance
         {
@@ -3,16 +3,17 @@
 
 #include <memory>
 #include <array>
-#include <random>
 #include <algorithm>
+#include <numeric>
 #include <cstdlib>
 
 #include "utility.h"
 
 #include "glm/glm.hpp"
-#include "glm/gtc/random.hpp"
 #include "olcPixelGameEngine.h"
 
+#include "random.h"
+
 // textures.h
 // (c) 2025 Connor J. Link. All Rights Reserved.
 
@@ -34,8 +35,8 @@ namespace ir
         Real amplitude = 1.f;
 
     private:
-        std::random_device device{};
-        std::mt19937 generator{ device() };
+        // fixed default seed so that the lattice, and therefore every render, is the same from run to run
+        Random generator{};
 
     private:
         void generate()
@@ -50,13 +51,14 @@ namespace ir
             {
                 for (auto j = 0; j < M; j++)
                 {
-                    std::uniform_int_distribution<> distribution(0, i);
-                    const auto swapee = distribution(generator);
+                    const auto swapee = generator.integer(i + 1);
                     std::swap(permutation[i][j], permutation[swapee][j]);
                 }
             }
         }
 
+    public:
+        // D octaves of noise, each at twice the frequency and half the weight of the last
         template<std::size_t D>
         Real turbulence(const glm::vec<M, Real>& point) const
         {
@@ -74,6 +76,7 @@ namespace ir
             return std::abs(sum);
         }
 
+    private:
         Real perlinlerp(PerlinInterpolationArray& sample, const glm::vec<M, Real>& uvw, const glm::vec<M, Real>& uvw_smoothed) const
         {
             auto sum = 0.f;
@@ -159,7 +162,7 @@ namespace ir
             // pre-populate a known sequence of random values
             std::transform(random.cbegin(), random.cend(), random.begin(), [&](auto)
             {
-                return glm::sphericalRand(1.f);
+                return generator.sphere(1.f);
             });
 
             generate();
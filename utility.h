@@ -1,6 +1,7 @@
 #ifndef IRRADIANCE_UTILITY_H
 #define IRRADIANCE_UTILITY_H
 
+#include <cstdint>
 #include <limits>
 #include <ranges>
 #include <string>
@@ -51,20 +52,33 @@ namespace ir
 
         /* albedo sampled from this texture if specified */
         olc::Sprite* texture = nullptr;
+
+        bool operator==(const PBRMaterial&) const = default;
     };
 
     struct Object;
 
     struct RayIntersection
     {
+        static constexpr std::uint32_t NO_FACE = std::numeric_limits<std::uint32_t>::max();
+
         glm::vec3 position;
         glm::vec3 normal;
-        PBRMaterial material;
+        // entry of the scene's material table for the primitive, or its instance's override, rather than a copy of the
+        // whole material in every hit. stays valid while rendering since the table only grows during scene setup
+        const PBRMaterial* material = nullptr;
         Real depth = std::numeric_limits<float>::infinity();
         Real exit = 0.f;
         bool hit;
+        // authoring object that was hit, null for faces of indexed meshes that were loaded rather than authored
         Object* object = nullptr;
+        // face of an indexed mesh that was hit, NO_FACE for any other primitive
+        std::uint32_t face = NO_FACE;
+        // index into the scene's instances of the one that was hit
+        std::uint32_t instance = 0;
         glm::vec2 uv;
+        // absorbed on the way to a scattering event inside a medium, to be applied to the albedo there
+        glm::vec3 attenuation = glm::vec3{ 1.f };
     };
 
     // (c) Connor J. Link. Attribution from personal work outside of ISU.
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <limits>
+
+#include "volume.h"
+
+// volume.cpp
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    DensityGrid::DensityGrid(const BoundingVolume& bounds, const glm::uvec3& resolution, std::vector<Real> voxels)
+        : origin{ bounds.origin }, size{ bounds.size }, resolution{ glm::max(resolution, glm::uvec3{ 1 }) }, voxels{ std::move(voxels) }
+    {
+        this->voxels.resize(static_cast<std::size_t>(this->resolution.x) * this->resolution.y * this->resolution.z, 0.f);
+        build();
+    }
+
+    DensityGrid::DensityGrid(const BoundingVolume& bounds, const glm::uvec3& resolution, const std::function<Real(const glm::vec3&)>& density)
+        : origin{ bounds.origin }, size{ bounds.size }, resolution{ glm::max(resolution, glm::uvec3{ 1 }) }
+    {
+        voxels.resize(static_cast<std::size_t>(this->resolution.x) * this->resolution.y * this->resolution.z);
+
+        const auto voxel_size = size / glm::vec3{ this->resolution };
+
+        auto index = 0uz;
+        for (auto z = 0u; z < this->resolution.z; z++)
+        {
+            for (auto y = 0u; y < this->resolution.y; y++)
+            {
+                for (auto x = 0u; x < this->resolution.x; x++)
+                {
+                    const auto centre = origin + (glm::vec3{ x, y, z } + .5f) * voxel_size;
+                    voxels[index++] = density(centre);
+                }
+            }
+        }
+
+        build();
+    }
+
+    void DensityGrid::build()
+    {
+        // negative densities would make tracking meaningless
+        for (auto& voxel : voxels)
+        {
+            voxel = glm::max(voxel, 0.f);
+        }
+
+        majorant_resolution = glm::min(resolution, glm::uvec3{ MAJORANT_RESOLUTION });
+
+        const auto count = static_cast<std::size_t>(majorant_resolution.x) * majorant_resolution.y * majorant_resolution.z;
+        minorants.assign(count, std::numeric_limits<Real>::max());
+        majorants.assign(count, 0.f);
+
+        // interpolation anywhere in a cell only ever mixes the voxels whose centres lie within one voxel of it,
+        // so their extremes bound the density there
+        const auto voxels_per_cell = glm::vec3{ resolution } / glm::vec3{ majorant_resolution };
+
+        auto index = 0uz;
+        for (auto z = 0u; z < majorant_resolution.z; z++)
+        {
+            for (auto y = 0u; y < majorant_resolution.y; y++)
+            {
+                for (auto x = 0u; x < majorant_resolution.x; x++)
+                {
+                    const auto cell = glm::vec3{ x, y, z };
+                    const auto first = glm::ivec3{ glm::floor(cell * voxels_per_cell - .5f) };
+                    const auto last = glm::ivec3{ glm::ceil((cell + 1.f) * voxels_per_cell - .5f) };
+
+                    const auto minimum = glm::clamp(first, glm::ivec3{ 0 }, glm::ivec3{ resolution } - 1);
+                    const auto maximum = glm::clamp(last, glm::ivec3{ 0 }, glm::ivec3{ resolution } - 1);
+
+                    for (auto k = minimum.z; k <= maximum.z; k++)
+                    {
+                        for (auto j = minimum.y; j <= maximum.y; j++)
+                        {
+                            for (auto i = minimum.x; i <= maximum.x; i++)
+                            {
+                                const auto voxel = voxels[(static_cast<std::size_t>(k) * resolution.y + j) * resolution.x + i];
+                                minorants[index] = glm::min(minorants[index], voxel);
+                                majorants[index] = glm::max(majorants[index], voxel);
+                            }
+                        }
+                    }
+
+                    index++;
+                }
+            }
+        }
+    }
+
+    Real DensityGrid::density(const glm::vec3& position) const
+    {
+        // continuous voxel coordinates, with voxel centres on the integers and clamped at the edges
+        const auto scaled = (position - origin) / size * glm::vec3{ resolution } - .5f;
+        const auto limit = glm::vec3{ resolution - 1u };
+        const auto clamped = glm::clamp(scaled, glm::vec3{ 0.f }, limit);
+
+        const auto lower = glm::uvec3{ glm::floor(clamped) };
+        const auto upper = glm::min(lower + 1u, resolution - 1u);
+        const auto t = clamped - glm::vec3{ lower };
+
+        const auto at = [&](std::uint32_t x, std::uint32_t y, std::uint32_t z)
+        {
+            return voxels[(static_cast<std::size_t>(z) * resolution.y + y) * resolution.x + x];
+        };
+
+        const auto x00 = glm::mix(at(lower.x, lower.y, lower.z), at(upper.x, lower.y, lower.z), t.x);
+        const auto x10 = glm::mix(at(lower.x, upper.y, lower.z), at(upper.x, upper.y, lower.z), t.x);
+        const auto x01 = glm::mix(at(lower.x, lower.y, upper.z), at(upper.x, lower.y, upper.z), t.x);
+        const auto x11 = glm::mix(at(lower.x, upper.y, upper.z), at(upper.x, upper.y, upper.z), t.x);
+
+        return glm::mix(glm::mix(x00, x10, t.y), glm::mix(x01, x11, t.y), t.z);
+    }
+
+    template<typename F>
+    void DensityGrid::traverse(const Ray& ray, Real entry, Real exit, F&& visit) const
+    {
+        // 3-D DDA over the majorant cells https://www.cse.yorku.ca/~amana/research/grid.pdf
+        const auto cell_size = size / glm::vec3{ majorant_resolution };
+        const auto start = ray.origin + ray.direction * entry;
+
+        auto cell = glm::ivec3{ glm::clamp(glm::floor((start - origin) / cell_size), glm::vec3{ 0.f }, glm::vec3{ majorant_resolution - 1u }) };
+
+        auto next = glm::vec3{ 0.f };
+        auto delta = glm::vec3{ 0.f };
+        auto step = glm::ivec3{ 0 };
+        for (auto axis = 0; axis < 3; axis++)
+        {
+            const auto direction = ray.direction[axis];
+            if (direction == 0.f)
+            {
+                next[axis] = std::numeric_limits<Real>::infinity();
+                delta[axis] = std::numeric_limits<Real>::infinity();
+                continue;
+            }
+
+            step[axis] = direction > 0.f ? 1 : -1;
+            const auto boundary = origin[axis] + static_cast<Real>(cell[axis] + (direction > 0.f)) * cell_size[axis];
+            next[axis] = (boundary - ray.origin[axis]) / direction;
+            delta[axis] = cell_size[axis] / glm::abs(direction);
+        }
+
+        auto t = entry;
+        while (t < exit)
+        {
+            const auto axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+            const auto t_next = glm::min(next[axis], exit);
+
+            const auto index = (static_cast<std::size_t>(cell.z) * majorant_resolution.y + cell.y) * majorant_resolution.x + cell.x;
+            if (t_next > t && visit(index, t, t_next))
+            {
+                return;
+            }
+
+            t = t_next;
+            cell[axis] += step[axis];
+            next[axis] += delta[axis];
+
+            if (cell[axis] < 0 || cell[axis] >= static_cast<int>(majorant_resolution[axis]))
+            {
+                return;
+            }
+        }
+    }
+
+    bool DensityGrid::track(const Ray& ray, Real entry, Real exit, Real& depth) const
+    {
+        const auto speed = glm::length(ray.direction);
+        auto collided = false;
+
+        traverse(ray, entry, exit, [&](std::size_t cell, Real t0, Real t1)
+        {
+            const auto majorant = majorants[cell];
+            if (majorant <= 0.f)
+            {
+                // nothing to collide with, so the whole cell is crossed in one step
+                return false;
+            }
+
+            // free flight restarts at every cell boundary, which the exponential distribution does not remember
+            auto t = t0;
+            while (true)
+            {
+                t -= glm::log(1.f - rng().uniform()) / (majorant * speed);
+                if (t >= t1)
+                {
+                    return false;
+                }
+
+                // a real collision in proportion to the density at the tentative one, otherwise a null one to pass through
+                if (rng().uniform() * majorant < density(ray.origin + ray.direction * t))
+                {
+                    depth = t;
+                    collided = true;
+                    return true;
+                }
+            }
+        });
+
+        return collided;
+    }
+
+    Real DensityGrid::transmittance(const Ray& ray, Real entry, Real exit) const
+    {
+        auto transmittance = 1.f;
+
+        traverse(ray, entry, exit, [&](std::size_t cell, Real t0, Real t1)
+        {
+            // the least density in the cell is the control, so only the variation above it costs any collisions
+            const auto control = minorants[cell];
+            const auto residual = majorants[cell] - control;
+
+            transmittance *= ratio_track(ray, t0, t1, control, residual, [&](const glm::vec3& position) { return density(position); });
+            return transmittance <= 0.f;
+        });
+
+        return transmittance;
+    }
+}
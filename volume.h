@@ -0,0 +1,98 @@
+#ifndef IRRADIANCE_VOLUME_H
+#define IRRADIANCE_VOLUME_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "utility.h"
+#include "hierarchy.h"
+#include "random.h"
+
+// volume.h
+// (c) 2025 Connor J. Link. All Rights Reserved.
+
+namespace ir
+{
+    // estimates exp(-integral of density) over [entry, exit] of the ray. the part explained by a constant control density
+    // is exact, and only the residual is tracked, by taking tentative collisions at its majorant and keeping the
+    // fraction of each that is not really there. a homogeneous medium is its own control and needs no collisions at all
+    // residual ratio tracking https://cs.dartmouth.edu/~wjarosz/publications/novak14residual.html
+    template<typename Density>
+    Real ratio_track(const Ray& ray, Real entry, Real exit, Real control, Real majorant, Density density)
+    {
+        const auto speed = glm::length(ray.direction);
+        const auto length = (exit - entry) * speed;
+
+        auto transmittance = glm::exp(-control * length);
+        if (majorant <= 0.f)
+        {
+            return transmittance;
+        }
+
+        auto travel = 0.f;
+        while (transmittance > 0.f)
+        {
+            travel -= glm::log(1.f - rng().uniform()) / majorant;
+            if (travel >= length)
+            {
+                break;
+            }
+
+            const auto position = ray.origin + ray.direction * (entry + travel / speed);
+            transmittance *= 1.f - (density(position) - control) / majorant;
+        }
+
+        return transmittance;
+    }
+
+    // density of a heterogeneous medium, sampled at the centres of a voxel grid over bounds and interpolated
+    // trilinearly in between. a much coarser grid holds the least and greatest density within each of its cells,
+    // so that tracking takes steps sized to the local density and skips empty cells outright
+    class DensityGrid
+    {
+    public:
+        // cells per side of the bounding grid, or fewer when the voxels themselves are fewer
+        static constexpr std::uint32_t MAJORANT_RESOLUTION = 16;
+
+    private:
+        glm::vec3 origin = glm::vec3{ 0.f };
+        glm::vec3 size = glm::vec3{ 1.f };
+        glm::uvec3 resolution = glm::uvec3{ 1 };
+        // x fastest, then y, then z
+        std::vector<Real> voxels;
+
+        glm::uvec3 majorant_resolution = glm::uvec3{ 1 };
+        std::vector<Real> minorants;
+        std::vector<Real> majorants;
+
+    public:
+        DensityGrid() = default;
+        // voxels holds resolution.x * resolution.y * resolution.z densities, x fastest
+        DensityGrid(const BoundingVolume& bounds, const glm::uvec3& resolution, std::vector<Real> voxels);
+        // bakes density, evaluated once at the centre of every voxel, such as a noise turbulence
+        DensityGrid(const BoundingVolume& bounds, const glm::uvec3& resolution, const std::function<Real(const glm::vec3&)>& density);
+
+    private:
+        void build();
+
+    public:
+        Real density(const glm::vec3& position) const;
+
+        // delta tracking from entry toward exit; true with the ray parameter of the first real collision, if any
+        // https://pbr-book.org/4ed/Volume_Scattering/Volume_Scattering_Processes#DeltaTracking
+        bool track(const Ray& ray, Real entry, Real exit, Real& depth) const;
+        // residual ratio tracking between entry and exit, cell by cell of the majorant grid
+        Real transmittance(const Ray& ray, Real entry, Real exit) const;
+
+    private:
+        // visits each majorant cell that [entry, exit] of the ray passes through, in order, with the part of the ray
+        // inside it, until visit returns true
+        template<typename F>
+        void traverse(const Ray& ray, Real entry, Real exit, F&& visit) const;
+    };
+}
+
+#endif